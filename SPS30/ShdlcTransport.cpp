@@ -135,12 +135,7 @@ Sps30Error ShdlcTransport::send(uint8_t addr, uint8_t cmd, ConstBytesView bytes)
     buffer.stuffData(addr, cmd, bytes);
     auto len = buffer.getSize();
     DEBUG_LOG("SHDLC::Send sending " << (int)len << " bytes: " << embedded::BytesView(buffer.begin(), len))
-    auto ret = uart.Send(buffer.begin(), len);
-    if (ret != len)
-    {
-        return Sps30Error::TransportError;
-    }
-    return Sps30Error::Success;
+    return toSps30Error(uart.Send(buffer.begin(), len) == len);
 }
 
 Sps30Error ShdlcTransport::sendAndReceive(const uint8_t addr,
@@ -160,7 +155,33 @@ ShdlcTransport::sendAndReceive(uint8_t addr, uint8_t cmd, embedded::ConstBytesVi
     {
         return ret;
     }
+    return receive(bytes);
+}
+
+Sps30Error ShdlcTransport::sendFrame(ConstBytesView frame) const
+{
+    DEBUG_LOG("SHDLC::Send sending prepared frame of " << (int)frame.size() << " bytes: " << frame)
+    return toSps30Error(uart.Send(frame.begin(), frame.size()) == frame.size());
+}
 
+Sps30Error ShdlcTransport::sendFrameAndReceive(ConstBytesView frame, const embedded::BytesView &bytes)
+{
+    auto resultView = bytes;
+    return sendFrameAndReceive(frame, resultView);
+}
+
+Sps30Error ShdlcTransport::sendFrameAndReceive(ConstBytesView frame, embedded::BytesView &bytes)
+{
+    auto ret = sendFrame(frame);
+    if (ret != Sps30Error::Success)
+    {
+        return ret;
+    }
+    return receive(bytes);
+}
+
+Sps30Error ShdlcTransport::receive(embedded::BytesView &bytes)
+{
     StuffedBuffer buffer;
 
     auto received = uart.ReceiveBetween(buffer.begin(), buffer.capacity(), 0x7e, 0x7e, 20);
@@ -198,7 +219,7 @@ ShdlcTransport::sendAndReceive(uint8_t addr, uint8_t cmd, embedded::ConstBytesVi
 Sps30Error ShdlcTransport::activateTransport()
 {
     const uint8_t data = 0xFF;
-    return uart.Send(&data, 1) == 1 ? Sps30Error::Success : Sps30Error::TransportError;
+    return toSps30Error(uart.Send(&data, 1) == 1);
 }
 
 }
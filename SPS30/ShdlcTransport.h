@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include "Sps30Error.h"
 #include "MemoryView.h"
@@ -8,6 +9,54 @@ namespace embedded
 {
 class PacketUart;
 
+namespace detail
+{
+
+constexpr bool isShdlcReservedByte(uint8_t byte)
+{
+    return byte == 0x11 || byte == 0x13 || byte == 0x7d || byte == 0x7e;
+}
+
+template<uint8_t... bytes>
+constexpr uint16_t shdlcStuffedSize()
+{
+    return (0 + ... + (isShdlcReservedByte(bytes) ? 2 : 1));
+}
+
+template<uint8_t... bytes>
+constexpr auto makeStuffedFrame()
+{
+    std::array<uint8_t, 2 + shdlcStuffedSize<bytes...>()> frame {};
+    uint16_t pos = 0;
+    frame[pos++] = 0x7e;
+    for (const uint8_t byte: { bytes... })
+    {
+        if (isShdlcReservedByte(byte))
+        {
+            frame[pos++] = 0x7d;
+            frame[pos++] = byte ^ (1 << 5);
+        }
+        else
+        {
+            frame[pos++] = byte;
+        }
+    }
+    frame[pos] = 0x7e;
+    return frame;
+}
+
+}
+
+// Complete MOSI frame with a constant payload: start/stop codes, checksum and byte stuffing are calculated
+// at compile time, so the frame can be sent as is by ShdlcTransport::sendFrame.
+template<uint8_t addr, uint8_t cmd, uint8_t... data>
+constexpr auto makeShdlcFrame()
+{
+    constexpr auto length = static_cast<uint8_t>(sizeof...(data));
+    constexpr auto crc = static_cast<uint8_t>(~(addr + cmd + length + (0 + ... + data)));
+    return detail::makeStuffedFrame<addr, cmd, length, data..., crc>();
+}
+
 class ShdlcTransport
 {
 public:
@@ -22,9 +71,17 @@ public:
 
     Sps30Error sendAndReceive(uint8_t addr, uint8_t cmd, embedded::ConstBytesView txData, embedded::BytesView &bytes);
 
+    Sps30Error sendFrame(ConstBytesView frame) const;
+
+    Sps30Error sendFrameAndReceive(ConstBytesView frame, const embedded::BytesView &rxData);
+
+    Sps30Error sendFrameAndReceive(ConstBytesView frame, embedded::BytesView &bytes);
+
     Sps30Error activateTransport();
 
 private:
+    Sps30Error receive(embedded::BytesView &bytes);
+
     embedded::PacketUart &uart;
 };
 
@@ -0,0 +1,151 @@
+#include "Sps30AirQualityIndex.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+
+struct AqiBreakpoint
+{
+    constexpr AqiBreakpoint(uint16_t concentrationLow, uint16_t concentrationHigh, uint16_t indexLow, uint16_t indexHigh)
+            : concentrationLow(concentrationLow)
+              , concentrationHigh(concentrationHigh)
+              , indexLow(indexLow)
+              , slope(((uint32_t(indexHigh - indexLow) << slopeShift) + (concentrationHigh - concentrationLow) / 2)
+                      / (concentrationHigh - concentrationLow)) {}
+
+    static constexpr uint8_t slopeShift = 20;
+
+    uint16_t concentrationLow;
+    uint16_t concentrationHigh;
+    uint16_t indexLow;
+    uint32_t slope; // index units per 0.1 ug/m3 in Q20
+};
+
+// US EPA breakpoints (2024 revision), concentrations in 0.1 ug/m3
+constexpr AqiBreakpoint pm25Breakpoints[] {
+        { 0, 90, 0, 50 },
+        { 91, 354, 51, 100 },
+        { 355, 554, 101, 150 },
+        { 555, 1254, 151, 200 },
+        { 1255, 2254, 201, 300 },
+        { 2255, 3254, 301, 500 },
+};
+
+constexpr AqiBreakpoint pm10Breakpoints[] {
+        { 0, 540, 0, 50 },
+        { 550, 1540, 51, 100 },
+        { 1550, 2540, 101, 150 },
+        { 2550, 3540, 151, 200 },
+        { 3550, 4240, 201, 300 },
+        { 4250, 6040, 301, 500 },
+};
+
+constexpr uint16_t maxUsAqi = 500;
+
+// upper bounds of the European Air Quality Index bands, 0.1 ug/m3
+constexpr uint16_t euPm25Bands[] { 100, 200, 250, 500, 750 };
+constexpr uint16_t euPm10Bands[] { 200, 400, 500, 1000, 1500 };
+
+constexpr uint16_t usCategoryBounds[] { 50, 100, 150, 200, 300 };
+
+template<size_t N>
+uint16_t interpolateAqi(const AqiBreakpoint (&table)[N], uint32_t concentration)
+{
+    for (const auto &breakpoint: table)
+    {
+        if (concentration <= breakpoint.concentrationHigh)
+        {
+            const auto delta = concentration - breakpoint.concentrationLow;
+            constexpr uint32_t half = 1u << (AqiBreakpoint::slopeShift - 1);
+            return uint16_t(breakpoint.indexLow + ((delta * breakpoint.slope + half) >> AqiBreakpoint::slopeShift));
+        }
+    }
+    return maxUsAqi;
+}
+
+template<size_t N>
+uint8_t findBand(const uint16_t (&bounds)[N], uint32_t value)
+{
+    uint8_t band = 0;
+    while (band < N && value > bounds[band])
+    {
+        ++band;
+    }
+    return band;
+}
+
+// converts the value to 0.1 units with truncation using integer operations only
+uint32_t toTenths(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const int exponent = int((bits >> 23) & 0xFF) - 127 - 23;
+    if ((bits & 0x80000000u) || (bits & 0x7F800000u) == 0)
+    {
+        return 0;  // negative, zero or denormalized
+    }
+    if (exponent > 8)
+    {
+        return UINT32_MAX; // doesn't fit, including infinity and NaN
+    }
+    const uint64_t scaled = uint64_t((bits & 0x7FFFFFu) | 0x800000u) * 10;
+    if (exponent >= 0)
+    {
+        const auto result = scaled << exponent;
+        return result > UINT32_MAX ? UINT32_MAX : uint32_t(result);
+    }
+    return exponent > -64 ? uint32_t(scaled >> -exponent) : 0;
+}
+
+}
+
+namespace embedded
+{
+
+uint16_t calculateUsAqiPm25(uint32_t pm25Tenths)
+{
+    return interpolateAqi(pm25Breakpoints, pm25Tenths);
+}
+
+uint16_t calculateUsAqiPm10(uint32_t pm10Tenths)
+{
+    // PM10 is truncated to the integer ug/m3 before the calculation
+    return interpolateAqi(pm10Breakpoints, pm10Tenths / 10 * 10);
+}
+
+UsAqiCategory getUsAqiCategory(uint16_t aqi)
+{
+    return UsAqiCategory(findBand(usCategoryBounds, aqi));
+}
+
+EuAqiCategory getEuAqiCategory(uint32_t pm25Tenths, uint32_t pm10Tenths)
+{
+    const auto pm25Band = findBand(euPm25Bands, pm25Tenths);
+    const auto pm10Band = findBand(euPm10Bands, pm10Tenths);
+    return EuAqiCategory(pm25Band > pm10Band ? pm25Band : pm10Band);
+}
+
+Sps30AirQuality calculateAirQuality(const Sps30MeasurementData &data)
+{
+    uint32_t pm25Tenths;
+    uint32_t pm10Tenths;
+    if (data.measureInFloat)
+    {
+        pm25Tenths = toTenths(data.floatData.mc_2p5);
+        pm10Tenths = toTenths(data.floatData.mc_10p0);
+    }
+    else
+    {
+        pm25Tenths = data.unsignedData.mc_2p5 * 10u;
+        pm10Tenths = data.unsignedData.mc_10p0 * 10u;
+    }
+
+    const auto pm25Aqi = calculateUsAqiPm25(pm25Tenths);
+    const auto pm10Aqi = calculateUsAqiPm10(pm10Tenths);
+    const auto aqi = pm25Aqi > pm10Aqi ? pm25Aqi : pm10Aqi;
+    return Sps30AirQuality { aqi, getUsAqiCategory(aqi), getEuAqiCategory(pm25Tenths, pm10Tenths) };
+}
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+
+#include <cstdint>
+
+namespace embedded
+{
+
+enum class UsAqiCategory : uint8_t
+{
+    Good, Moderate, UnhealthyForSensitiveGroups, Unhealthy, VeryUnhealthy, Hazardous
+};
+
+enum class EuAqiCategory : uint8_t
+{
+    Good, Fair, Moderate, Poor, VeryPoor, ExtremelyPoor
+};
+
+struct Sps30AirQuality
+{
+    uint16_t usAqi;            // US EPA AQI, the worst of PM2.5 and PM10 sub-indices
+    UsAqiCategory usCategory;
+    EuAqiCategory euCategory;  // EEA European Air Quality Index band, the worst of PM2.5 and PM10 bands
+};
+
+// All the calculations are done in the integer arithmetic with concentrations in 0.1 ug/m3 units,
+// the breakpoint tables are constant and are kept in flash.
+uint16_t calculateUsAqiPm25(uint32_t pm25Tenths);
+uint16_t calculateUsAqiPm10(uint32_t pm10Tenths);
+UsAqiCategory getUsAqiCategory(uint16_t aqi);
+EuAqiCategory getEuAqiCategory(uint32_t pm25Tenths, uint32_t pm10Tenths);
+
+// Accepts measurements in both formats, the float values are converted to the fixed point without FPU operations.
+Sps30AirQuality calculateAirQuality(const Sps30MeasurementData &data);
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace embedded
+{
+
+namespace detail
+{
+
+template<uint8_t bits, uint8_t polynomial>
+constexpr std::array<uint8_t, 1 << bits> makeCrc8Table()
+{
+    std::array<uint8_t, 1 << bits> table {};
+    for (unsigned index = 0; index < table.size(); ++index)
+    {
+        auto crc = static_cast<uint8_t>(index << (8 - bits));
+        for (uint8_t bit = 0; bit < bits; ++bit)
+        {
+            crc = static_cast<uint8_t>((crc & 0x80) ? (crc << 1) ^ polynomial : crc << 1);
+        }
+        table[index] = crc;
+    }
+    return table;
+}
+
+}
+
+// CRC-8 used by SPS30 I2C interface: polynomial 0x31, initial value 0xFF, calculated over 2-byte words.
+// The full 256-entry table is used by default, define SPS30_CRC_NIBBLE_TABLE to use 16-entry table
+// for flash-tight builds.
+class Sps30Crc
+{
+public:
+    static constexpr uint8_t wordSize = 2;
+    static constexpr uint8_t tripletSize = wordSize + 1;
+
+    static constexpr uint8_t calculate(const uint8_t data[wordSize])
+    {
+        return update(update(initialValue, data[0]), data[1]);
+    }
+
+    // Checks [d0 d1 crc] triplets and packs the data words to the beginning of the buffer in a single pass.
+    // Returns false if the size isn't a whole number of triplets or any checksum mismatches.
+    static bool compactReply(uint8_t *buffer, uint16_t size)
+    {
+        if (size % tripletSize != 0)
+        {
+            return false;
+        }
+        const uint8_t *source = buffer;
+        const uint8_t *const last = buffer + size;
+        for (; source != last; source += tripletSize, buffer += wordSize)
+        {
+            const auto d0 = source[0];
+            const auto d1 = source[1];
+            if (update(update(initialValue, d0), d1) != source[2])
+            {
+                return false;
+            }
+            buffer[0] = d0;
+            buffer[1] = d1;
+        }
+        return true;
+    }
+
+private:
+    static constexpr uint8_t polynomial = 0x31;
+    static constexpr uint8_t initialValue = 0xFF;
+
+#ifdef SPS30_CRC_NIBBLE_TABLE
+    static constexpr auto table = detail::makeCrc8Table<4, polynomial>();
+
+    static constexpr uint8_t update(uint8_t crc, uint8_t byte)
+    {
+        crc ^= byte;
+        crc = static_cast<uint8_t>(crc << 4) ^ table[crc >> 4];
+        return static_cast<uint8_t>(crc << 4) ^ table[crc >> 4];
+    }
+#else
+    static constexpr auto table = detail::makeCrc8Table<8, polynomial>();
+
+    static constexpr uint8_t update(uint8_t crc, uint8_t byte)
+    {
+        return table[crc ^ byte];
+    }
+#endif
+};
+
+}
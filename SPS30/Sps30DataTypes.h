@@ -40,6 +40,12 @@ struct Sps30MeasurementData
     bool measureInFloat;
 };
 
+// Leading subset of the measured values to be read, the values after the subset aren't transferred
+enum class Sps30MeasurementFields : uint8_t
+{
+    Mass = 4, MassAndNumber = 9, All = 10
+};
+
 struct Sps30ShdlcInformation
 {
     uint8_t hardware_revision;
@@ -5,7 +5,12 @@ namespace embedded
 
 enum class Sps30Error
 {
-    Success, TransportError, DataError, UnsupportedCommand
+    Success, TransportError, DataError, UnsupportedCommand, NotReady
 };
 
+constexpr Sps30Error toSps30Error(bool transportSucceeded)
+{
+    return transportSucceeded ? Sps30Error::Success : Sps30Error::TransportError;
+}
+
 }
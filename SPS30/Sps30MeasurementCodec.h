@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+#include "Sps30Error.h"
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+namespace embedded
+{
+
+// Decoder of the big-endian measurement payload shared by I2C and UART drivers.
+// The format is selected at compile time: 10 floats (40 bytes) or 10 unsigned words (20 bytes).
+template<bool inFloat>
+struct Sps30MeasurementCodec
+{
+    using Word = std::conditional_t<inFloat, uint32_t, uint16_t>;
+
+    static constexpr uint8_t fieldsCount = 10;
+    static constexpr uint8_t payloadSize = fieldsCount * sizeof(Word);
+
+    static_assert(sizeof(std::conditional_t<inFloat,
+                                            decltype(Sps30MeasurementData::floatData),
+                                            decltype(Sps30MeasurementData::unsignedData)>) == payloadSize,
+                  "Measurement data layout mismatch with the sensor payload");
+
+    static constexpr uint8_t payloadSizeOf(Sps30MeasurementFields fields)
+    {
+        return static_cast<uint8_t>(fields) * sizeof(Word);
+    }
+
+    // Decodes the leading fields of the measurement, the rest of the fields are zeroed
+    static void decode(const uint8_t *payload, Sps30MeasurementData &result,
+                       Sps30MeasurementFields fields = Sps30MeasurementFields::All)
+    {
+        auto *target = reinterpret_cast<uint8_t *>(&result.floatData);
+        const auto *const last = payload + payloadSizeOf(fields);
+        for (; payload != last; payload += sizeof(Word), target += sizeof(Word))
+        {
+            Word word;
+            std::memcpy(&word, payload, sizeof(word));
+            word = byteSwap(word);
+            std::memcpy(target, &word, sizeof(word));
+        }
+        std::memset(target, 0, payloadSize - payloadSizeOf(fields));
+        result.measureInFloat = inFloat;
+    }
+
+private:
+    static Word byteSwap(Word word)
+    {
+        if constexpr (inFloat)
+        {
+            return __builtin_bswap32(word);
+        }
+        else
+        {
+            return __builtin_bswap16(word);
+        }
+    }
+};
+
+using Sps30FloatMeasurementCodec = Sps30MeasurementCodec<true>;
+using Sps30UnsignedMeasurementCodec = Sps30MeasurementCodec<false>;
+
+// Decodes the payload recognizing its format by the size. An empty payload means no new measurement.
+inline std::variant<Sps30Error, Sps30MeasurementData> decodeMeasurement(const uint8_t *payload, uint16_t size)
+{
+    Sps30MeasurementData result;
+    switch (size)
+    {
+        case Sps30FloatMeasurementCodec::payloadSize:
+            Sps30FloatMeasurementCodec::decode(payload, result);
+            return result;
+        case Sps30UnsignedMeasurementCodec::payloadSize:
+            Sps30UnsignedMeasurementCodec::decode(payload, result);
+            return result;
+        case 0:
+            return Sps30Error::NotReady;
+        default:
+            return Sps30Error::DataError;
+    }
+}
+
+// Converts a measurement to the unsigned format with the sensor's own units:
+// concentrations are rounded to integers and the typical particle size is converted from um to nm.
+inline Sps30MeasurementData quantizeMeasurement(const Sps30MeasurementData &data)
+{
+    if (!data.measureInFloat)
+    {
+        return data;
+    }
+
+    const auto quantize = [](float value) -> uint16_t
+    {
+        if (!(value > 0.f))
+        {
+            return 0;
+        }
+        return value < 65535.f ? static_cast<uint16_t>(value + 0.5f) : uint16_t(65535);
+    };
+    const auto &source = data.floatData;
+    return Sps30MeasurementData {
+            .unsignedData {
+                    .mc_1p0 = quantize(source.mc_1p0),
+                    .mc_2p5 = quantize(source.mc_2p5),
+                    .mc_4p0 = quantize(source.mc_4p0),
+                    .mc_10p0 = quantize(source.mc_10p0),
+                    .nc_0p5 = quantize(source.nc_0p5),
+                    .nc_1p0 = quantize(source.nc_1p0),
+                    .nc_2p5 = quantize(source.nc_2p5),
+                    .nc_4p0 = quantize(source.nc_4p0),
+                    .nc_10p0 = quantize(source.nc_10p0),
+                    .typical_particle_size = quantize(source.typical_particle_size * 1000.f)
+            },
+            .measureInFloat = false
+    };
+}
+
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+#include "Sps30MeasurementCodec.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace embedded
+{
+
+// Fixed-capacity ring store of measurements in the unsigned format.
+// The oldest and the newest samples are kept as is, every other sample is stored as
+// a record of zigzag/varint encoded differences from the previous one.
+// When the buffer is full the oldest samples are dropped to make room for new ones.
+template<uint16_t capacityBytes>
+class Sps30MeasurementStore
+{
+    static constexpr uint8_t fieldsCount = Sps30UnsignedMeasurementCodec::fieldsCount;
+    // a difference of two 16-bit values takes 17 bits after zigzag encoding, i.e. up to 3 varint bytes
+    static constexpr uint8_t maxRecordSize = fieldsCount * 3;
+
+    static_assert(capacityBytes >= maxRecordSize, "The store should be able to keep at least one record");
+
+    using Sample = std::array<uint16_t, fieldsCount>;
+
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Sps30MeasurementData;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Sps30MeasurementData *;
+        using reference = Sps30MeasurementData;
+
+        Sps30MeasurementData operator*() const { return toMeasurement(value); }
+
+        Iterator &operator++()
+        {
+            if (--remaining != 0)
+            {
+                position = store->decodeRecord(position, value);
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return remaining == other.remaining; }
+
+        bool operator!=(const Iterator &other) const { return remaining != other.remaining; }
+
+    private:
+        friend class Sps30MeasurementStore;
+
+        Iterator(const Sps30MeasurementStore &store, uint16_t remaining)
+                : store(&store), value(store.oldest), position(store.head), remaining(remaining) {}
+
+        const Sps30MeasurementStore *store;
+        Sample value;
+        uint16_t position;
+        uint16_t remaining;
+    };
+
+    void push(const Sps30MeasurementData &data)
+    {
+        const auto sample = toSample(quantizeMeasurement(data));
+        if (count == 0)
+        {
+            oldest = newest = sample;
+            count = 1;
+            return;
+        }
+
+        uint8_t record[maxRecordSize];
+        uint8_t recordSize = 0;
+        for (uint8_t i = 0; i < fieldsCount; ++i)
+        {
+            const auto delta = int32_t(sample[i]) - int32_t(newest[i]);
+            auto zigzag = (uint32_t(delta) << 1) ^ uint32_t(delta >> 31);
+            while (zigzag >= 0x80)
+            {
+                record[recordSize++] = uint8_t(zigzag | 0x80);
+                zigzag >>= 7;
+            }
+            record[recordSize++] = uint8_t(zigzag);
+        }
+
+        while (capacityBytes - used < recordSize)
+        {
+            dropOldest();
+        }
+
+        auto position = wrap(uint32_t(head) + used);
+        for (uint8_t i = 0; i < recordSize; ++i)
+        {
+            buffer[position] = record[i];
+            position = next(position);
+        }
+        used += recordSize;
+        newest = sample;
+        ++count;
+    }
+
+    void dropOldest()
+    {
+        if (count > 1)
+        {
+            const auto position = decodeRecord(head, oldest);
+            // records are never empty, so the same position means the record took the whole ring
+            used -= uint16_t(position > head ? position - head : uint32_t(capacityBytes) - head + position);
+            head = position;
+            --count;
+        }
+        else
+        {
+            clear();
+        }
+    }
+
+    void clear()
+    {
+        head = used = count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+
+    uint16_t size() const { return count; }
+
+    uint16_t usedBytes() const { return used; }
+
+    Sps30MeasurementData front() const { return toMeasurement(oldest); }
+
+    Sps30MeasurementData back() const { return toMeasurement(newest); }
+
+    Iterator begin() const { return Iterator(*this, count); }
+
+    Iterator end() const { return Iterator(*this, 0); }
+
+private:
+    // the sum of two positions may exceed 16 bits for the capacities above 32767
+    static uint16_t wrap(uint32_t position)
+    {
+        return uint16_t(position < capacityBytes ? position : position - capacityBytes);
+    }
+
+    static uint16_t next(uint16_t position)
+    {
+        return ++position == capacityBytes ? 0 : position;
+    }
+
+    static Sample toSample(const Sps30MeasurementData &data)
+    {
+        Sample sample;
+        std::memcpy(sample.data(), &data.unsignedData, sizeof(sample));
+        return sample;
+    }
+
+    static Sps30MeasurementData toMeasurement(const Sample &sample)
+    {
+        Sps30MeasurementData data;
+        std::memcpy(&data.unsignedData, sample.data(), sizeof(sample));
+        data.measureInFloat = false;
+        return data;
+    }
+
+    // applies the record starting at the position to the sample and returns the position of the next record
+    uint16_t decodeRecord(uint16_t position, Sample &sample) const
+    {
+        for (auto &field: sample)
+        {
+            uint32_t zigzag = 0;
+            uint8_t shift = 0;
+            uint8_t byte;
+            do
+            {
+                byte = buffer[position];
+                position = next(position);
+                zigzag |= uint32_t(byte & 0x7f) << shift;
+                shift += 7;
+            } while (byte & 0x80);
+            const auto delta = int32_t(zigzag >> 1) ^ -int32_t(zigzag & 1);
+            field = uint16_t(field + delta);
+        }
+        return position;
+    }
+
+    std::array<uint8_t, capacityBytes> buffer;
+    Sample oldest {};
+    Sample newest {};
+    uint16_t head = 0;
+    uint16_t used = 0;
+    uint16_t count = 0;
+};
+
+}
@@ -0,0 +1,294 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+#include "Sps30Error.h"
+#include "Sps30Sensor.h"
+#include "Delays.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <variant>
+
+namespace embedded
+{
+
+// Duty-cycled measurement scheduler for Sps30I2C, Sps30Uart or Sps30Sensor over any of them.
+// Every sampling period the sensor is woken up and started, the samples produced during the warm-up
+// are skipped, the configured number of new samples is averaged and the sensor is stopped and put asleep.
+// If the samples can't be read within twice the nominal time the cycle is aborted and the sensor is stopped.
+// If the firmware doesn't support the sleep mode the sensor is left in the idle mode between cycles.
+template<typename Sensor>
+class Sps30PowerManager
+{
+    static_assert(isSps30Driver<Sensor>, "The sensor doesn't provide SPS30 driver interface");
+
+public:
+    struct Config
+    {
+        uint32_t samplingPeriodMs;
+        uint32_t warmUpMs = 30000; // the datasheet guarantees valid data within 8-30 s after start
+        uint8_t samplesToAverage = 10;
+        bool floating = true;
+    };
+
+    Sps30PowerManager(Sensor &sensor, const Config &config)
+            : sensor(sensor), config(config) {}
+
+    // Drives the cycle and should be called periodically.
+    // Returns the averaged measurement when a cycle is completed and Sps30Error::NotReady in between.
+    std::variant<Sps30Error, Sps30MeasurementData> process()
+    {
+        const uint32_t now = embedded::getMillisecondTicks();
+        if (!started)
+        {
+            started = true;
+            firstCycleTicks = now;
+            cycleStartTicks = now - config.samplingPeriodMs;
+        }
+
+        switch (state)
+        {
+            case State::Idle:
+                if (now - cycleStartTicks >= config.samplingPeriodMs)
+                {
+                    // a failed start is retried on the next call
+                    if (const auto error = startCycle(); error != Sps30Error::Success)
+                    {
+                        return error;
+                    }
+                    cycleStartTicks = now;
+                    measuringSinceTicks = now;
+                    state = State::WarmingUp;
+                }
+                break;
+            case State::WarmingUp:
+                if (now - measuringSinceTicks >= config.warmUpMs)
+                {
+                    samplesCount = 0;
+                    samplingSinceTicks = now;
+                    lastPollTicks = now - pollIntervalMs;
+                    state = State::Sampling;
+                }
+                break;
+            case State::Sampling:
+                if (now - lastPollTicks >= pollIntervalMs)
+                {
+                    lastPollTicks = now;
+                    return takeSample(now);
+                }
+                break;
+            case State::Stopping:
+                return stopCycle(now);
+        }
+        return Sps30Error::NotReady;
+    }
+
+    // Share of the time the fan and laser were running since the first cycle, in permille
+    uint16_t dutyCyclePermille() const
+    {
+        auto active = uint64_t(activeMs);
+        if (state != State::Idle)
+        {
+            active += embedded::getMillisecondTicks() - measuringSinceTicks;
+        }
+        const auto total = elapsedMs();
+        return total ? uint16_t(active * 1000 / total) : 0;
+    }
+
+    uint32_t activeTimeMs() const { return activeMs; }
+
+    uint32_t elapsedMs() const { return started ? embedded::getMillisecondTicks() - firstCycleTicks : 0; }
+
+    bool isSleepSupported() const { return sleepSupported; }
+
+private:
+    static constexpr uint16_t sampleIntervalMs = 1000;
+    static constexpr uint16_t pollIntervalMs = 100;
+    static constexpr uint8_t fieldsCount = 10;
+
+    enum class State
+    {
+        Idle, WarmingUp, Sampling, Stopping
+    };
+
+    // the sampling is aborted if the samples aren't collected within twice the nominal time
+    uint32_t samplingTimeoutMs() const
+    {
+        return uint32_t(config.samplesToAverage) * sampleIntervalMs * 2 + sampleIntervalMs;
+    }
+
+    Sps30Error startCycle()
+    {
+        if (asleep)
+        {
+            if (const auto error = sensor.wakeUp(); error != Sps30Error::Success)
+            {
+                return error;
+            }
+            asleep = false;
+        }
+        if (const auto error = sensor.startMeasurement(config.floating); error != Sps30Error::Success)
+        {
+            return error;
+        }
+        measuring = true;
+        return Sps30Error::Success;
+    }
+
+    // The state is changed only after the stop succeeds, so the failed one is retried on the next call.
+    // The sleep is optional: the sensor stays in the idle mode if it fails and the sleep is tried again
+    // after the next cycle, only the firmware without the sleep mode disables it.
+    Sps30Error finishCycle()
+    {
+        if (measuring)
+        {
+            if (const auto error = sensor.stopMeasurement(); error != Sps30Error::Success)
+            {
+                return error;
+            }
+            measuring = false;
+        }
+        if (sleepSupported)
+        {
+            const auto error = sensor.sleep();
+            sleepSupported = error != Sps30Error::UnsupportedCommand;
+            asleep = error == Sps30Error::Success;
+        }
+        return Sps30Error::Success;
+    }
+
+    std::variant<Sps30Error, Sps30MeasurementData> stopCycle(uint32_t now)
+    {
+        if (const auto error = finishCycle(); error != Sps30Error::Success)
+        {
+            return error;
+        }
+        activeMs += now - measuringSinceTicks;
+        state = State::Idle;
+        if (cycleCompleted)
+        {
+            return average();
+        }
+        return abortError;
+    }
+
+    std::variant<Sps30Error, Sps30MeasurementData> takeSample(uint32_t now)
+    {
+        // only a new sample is returned, so the same one can't be counted twice
+        auto result = readNewMeasurement();
+        if (const auto error = std::get_if<Sps30Error>(&result))
+        {
+            if (now - samplingSinceTicks < samplingTimeoutMs())
+            {
+                return *error;
+            }
+            // the sensor doesn't provide the data, don't keep the fan running
+            cycleCompleted = false;
+            abortError = *error == Sps30Error::NotReady ? Sps30Error::DataError : *error;
+            state = State::Stopping;
+            return stopCycle(now);
+        }
+        accumulate(std::get<Sps30MeasurementData>(result));
+        if (++samplesCount < config.samplesToAverage)
+        {
+            return Sps30Error::NotReady;
+        }
+
+        cycleCompleted = true;
+        state = State::Stopping;
+        return stopCycle(now);
+    }
+
+    std::variant<Sps30Error, Sps30MeasurementData> readNewMeasurement()
+    {
+        if constexpr (detail::HasReadMeasurementIfReady<Sensor>::value)
+        {
+            return sensor.readMeasurementIfReady();
+        }
+        else
+        {
+            // the UART sensor replies with no data if there is no new measurement
+            return sensor.readMeasurement();
+        }
+    }
+
+    void accumulate(const Sps30MeasurementData &data)
+    {
+        if (samplesCount == 0)
+        {
+            sums = {};
+            inFloat = data.measureInFloat;
+        }
+        if (inFloat)
+        {
+            std::array<float, fieldsCount> values;
+            std::memcpy(values.data(), &data.floatData, sizeof(values));
+            for (uint8_t i = 0; i < fieldsCount; ++i)
+            {
+                sums[i].floating += values[i];
+            }
+        }
+        else
+        {
+            std::array<uint16_t, fieldsCount> values;
+            std::memcpy(values.data(), &data.unsignedData, sizeof(values));
+            for (uint8_t i = 0; i < fieldsCount; ++i)
+            {
+                sums[i].integer += values[i];
+            }
+        }
+    }
+
+    Sps30MeasurementData average() const
+    {
+        Sps30MeasurementData result;
+        result.measureInFloat = inFloat;
+        if (inFloat)
+        {
+            std::array<float, fieldsCount> values;
+            for (uint8_t i = 0; i < fieldsCount; ++i)
+            {
+                values[i] = sums[i].floating / samplesCount;
+            }
+            std::memcpy(&result.floatData, values.data(), sizeof(values));
+        }
+        else
+        {
+            std::array<uint16_t, fieldsCount> values;
+            for (uint8_t i = 0; i < fieldsCount; ++i)
+            {
+                values[i] = uint16_t((sums[i].integer + samplesCount / 2) / samplesCount);
+            }
+            std::memcpy(&result.unsignedData, values.data(), sizeof(values));
+        }
+        return result;
+    }
+
+    union Sum
+    {
+        float floating;
+        uint32_t integer;
+    };
+
+    Sensor &sensor;
+    Config config;
+    State state = State::Idle;
+    std::array<Sum, fieldsCount> sums {};
+    uint32_t firstCycleTicks = 0;
+    uint32_t cycleStartTicks = 0;
+    uint32_t measuringSinceTicks = 0;
+    uint32_t samplingSinceTicks = 0;
+    uint32_t lastPollTicks = 0;
+    uint32_t activeMs = 0;
+    uint8_t samplesCount = 0;
+    Sps30Error abortError = Sps30Error::DataError;
+    bool inFloat = true;
+    bool started = false;
+    bool asleep = false;
+    bool measuring = false;
+    bool cycleCompleted = false;
+    bool sleepSupported = true;
+};
+
+}
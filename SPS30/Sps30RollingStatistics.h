@@ -0,0 +1,248 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+#include "Sps30MeasurementCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace embedded
+{
+
+// Statistics over the last windowSize values with fixed memory footprint.
+// Mean is O(1) per sample, min and max are amortized O(1) by monotonic queues,
+// median is O(log N) search plus a shift of the small sorted window.
+template<typename T, uint8_t windowSize>
+class RollingStatistics
+{
+    static_assert(windowSize > 0, "Window can't be empty");
+
+    using Sum = std::conditional_t<std::is_floating_point_v<T>, T, uint32_t>;
+
+public:
+    void add(T value)
+    {
+        if (count == windowSize)
+        {
+            const auto oldest = window[position];
+            sum -= oldest;
+            const auto it = std::lower_bound(sorted.begin(), sorted.begin() + count, oldest);
+            std::copy(it + 1, sorted.begin() + count, it);
+            --count;
+        }
+
+        window[position] = value;
+        sum += value;
+        const auto it = std::upper_bound(sorted.begin(), sorted.begin() + count, value);
+        std::copy_backward(it, sorted.begin() + count, sorted.begin() + count + 1);
+        *it = value;
+        ++count;
+
+        const uint32_t firstSequence = sequence + 1 - count;
+        minimums.expire(firstSequence);
+        maximums.expire(firstSequence);
+        minimums.push(sequence, value, [](T queued, T added) { return queued >= added; });
+        maximums.push(sequence, value, [](T queued, T added) { return queued <= added; });
+        ++sequence;
+
+        if (++position == windowSize)
+        {
+            position = 0;
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                // drop the rounding error accumulated by the incremental updates
+                sum = 0;
+                for (auto item: window)
+                {
+                    sum += item;
+                }
+            }
+        }
+    }
+
+    void clear()
+    {
+        count = position = 0;
+        sum = 0;
+        minimums.clear();
+        maximums.clear();
+    }
+
+    uint8_t size() const { return count; }
+
+    bool empty() const { return count == 0; }
+
+    T mean() const
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return count ? sum / count : T(0);
+        }
+        else
+        {
+            return count ? T((sum + count / 2) / count) : T(0);
+        }
+    }
+
+    T min() const { return count ? minimums.front() : T(0); }
+
+    T max() const { return count ? maximums.front() : T(0); }
+
+    T median() const
+    {
+        if (count == 0)
+        {
+            return T(0);
+        }
+        const auto middle = count / 2;
+        if (count & 1)
+        {
+            return sorted[middle];
+        }
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return (sorted[middle - 1] + sorted[middle]) / 2;
+        }
+        else
+        {
+            return T((Sum(sorted[middle - 1]) + sorted[middle] + 1) / 2);
+        }
+    }
+
+private:
+    // values ordered by arrival which are still candidates for the minimum or the maximum
+    class MonotonicQueue
+    {
+    public:
+        template<typename Dominates>
+        void push(uint32_t sequence, T value, Dominates dominates)
+        {
+            while (length && dominates(items[last()].value, value))
+            {
+                --length;
+            }
+            items[(head + length) % windowSize] = { sequence, value };
+            ++length;
+        }
+
+        void expire(uint32_t firstSequence)
+        {
+            while (length && int32_t(items[head].sequence - firstSequence) < 0)
+            {
+                head = (head + 1) % windowSize;
+                --length;
+            }
+        }
+
+        T front() const { return items[head].value; }
+
+        void clear() { head = length = 0; }
+
+    private:
+        uint8_t last() const { return (head + length - 1) % windowSize; }
+
+        struct Item
+        {
+            uint32_t sequence;
+            T value;
+        };
+
+        std::array<Item, windowSize> items;
+        uint8_t head = 0;
+        uint8_t length = 0;
+    };
+
+    std::array<T, windowSize> window;
+    std::array<T, windowSize> sorted;
+    MonotonicQueue minimums;
+    MonotonicQueue maximums;
+    Sum sum = 0;
+    uint32_t sequence = 0;
+    uint8_t position = 0;
+    uint8_t count = 0;
+};
+
+// Rolling statistics of all the measured values in the float or unsigned format.
+// Measurements in the other format are converted: the float ones are quantized, the unsigned ones are widened.
+template<bool inFloat, uint8_t windowSize>
+class Sps30MeasurementStatistics
+{
+    using Value = std::conditional_t<inFloat, float, uint16_t>;
+    static constexpr uint8_t fieldsCount = Sps30MeasurementCodec<inFloat>::fieldsCount;
+    using Values = std::array<Value, fieldsCount>;
+
+public:
+    void add(const Sps30MeasurementData &data)
+    {
+        const auto values = toValues(data);
+        for (uint8_t i = 0; i < fieldsCount; ++i)
+        {
+            fields[i].add(values[i]);
+        }
+    }
+
+    void clear()
+    {
+        for (auto &field: fields)
+        {
+            field.clear();
+        }
+    }
+
+    uint8_t size() const { return fields[0].size(); }
+
+    Sps30MeasurementData mean() const { return collect(&Field::mean); }
+
+    Sps30MeasurementData min() const { return collect(&Field::min); }
+
+    Sps30MeasurementData max() const { return collect(&Field::max); }
+
+    Sps30MeasurementData median() const { return collect(&Field::median); }
+
+private:
+    using Field = RollingStatistics<Value, windowSize>;
+
+    static Values toValues(const Sps30MeasurementData &data)
+    {
+        Values values;
+        if constexpr (inFloat)
+        {
+            if (!data.measureInFloat)
+            {
+                std::array<uint16_t, fieldsCount> integers;
+                std::memcpy(integers.data(), &data.unsignedData, sizeof(integers));
+                std::copy(integers.begin(), integers.end(), values.begin());
+                // the typical particle size is reported in nm in the unsigned format and in um in the float one
+                values.back() /= 1000.f;
+                return values;
+            }
+            std::memcpy(values.data(), &data.floatData, sizeof(values));
+        }
+        else
+        {
+            const auto quantized = quantizeMeasurement(data);
+            std::memcpy(values.data(), &quantized.unsignedData, sizeof(values));
+        }
+        return values;
+    }
+
+    Sps30MeasurementData collect(Value (Field::*statistic)() const) const
+    {
+        Values values;
+        for (uint8_t i = 0; i < fieldsCount; ++i)
+        {
+            values[i] = (fields[i].*statistic)();
+        }
+        Sps30MeasurementData result;
+        std::memcpy(&result.floatData, values.data(), sizeof(values));
+        result.measureInFloat = inFloat;
+        return result;
+    }
+
+    std::array<Field, fieldsCount> fields;
+};
+
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "Sps30DataTypes.h"
+#include "Sps30Error.h"
+#include "Sps30MeasurementCodec.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace embedded
+{
+
+namespace detail
+{
+
+template<typename T, typename = void>
+struct IsSps30Driver : std::false_type {};
+
+template<typename T>
+struct IsSps30Driver<T, std::void_t<
+        decltype(std::declval<T &>().probe()),
+        decltype(std::declval<T &>().getSerial(std::declval<Sps30SerialNumber &>())),
+        decltype(std::declval<T &>().getVersion()),
+        decltype(std::declval<T &>().startMeasurement(true)),
+        decltype(std::declval<T &>().stopMeasurement()),
+        decltype(std::declval<T &>().readMeasurement()),
+        decltype(std::declval<T &>().sleep()),
+        decltype(std::declval<T &>().wakeUp()),
+        decltype(std::declval<T &>().resetSensor()),
+        decltype(std::declval<T &>().getFanAutoCleaningInterval()),
+        decltype(std::declval<T &>().setFanAutoCleaningInterval(0)),
+        decltype(std::declval<T &>().startManualFanCleaning())>> : std::true_type {};
+
+template<typename T, typename = void>
+struct HasPartialReadMeasurement : std::false_type {};
+
+template<typename T>
+struct HasPartialReadMeasurement<T, std::void_t<
+        decltype(std::declval<T &>().readMeasurement(Sps30MeasurementFields::All))>> : std::true_type {};
+
+template<typename T, typename = void>
+struct HasReadMeasurementIfReady : std::false_type {};
+
+template<typename T>
+struct HasReadMeasurementIfReady<T, std::void_t<decltype(std::declval<T &>().readMeasurementIfReady())>>
+        : std::true_type {};
+
+}
+
+// True for the types providing the common SPS30 driver interface, i.e. Sps30I2C and Sps30Uart.
+template<typename T>
+inline constexpr bool isSps30Driver = detail::IsSps30Driver<T>::value;
+
+// Statically dispatched facade over Sps30I2C or Sps30Uart.
+// Allows to write the acquisition code once for both transports without virtual calls.
+template<typename Driver>
+class Sps30Sensor
+{
+    static_assert(isSps30Driver<Driver>, "The driver doesn't provide SPS30 driver interface");
+
+public:
+    explicit Sps30Sensor(Driver &driver) : sps30(driver) {}
+
+    Driver &driver() { return sps30; }
+
+    Sps30Error probe() { return sps30.probe(); }
+
+    Sps30Error getSerial(Sps30SerialNumber &serial) { return sps30.getSerial(serial); }
+
+    std::variant<Sps30Error, Sps30VersionInformation> getVersion() { return sps30.getVersion(); }
+
+    Sps30Error startMeasurement(bool floating = true) { return sps30.startMeasurement(floating); }
+
+    Sps30Error stopMeasurement() { return sps30.stopMeasurement(); }
+
+    std::variant<Sps30Error, Sps30MeasurementData> readMeasurement() { return sps30.readMeasurement(); }
+
+    // Transfers only the requested values if the transport allows it (I2C), reads all of them otherwise.
+    std::variant<Sps30Error, Sps30MeasurementData> readMeasurement(Sps30MeasurementFields fields)
+    {
+        if constexpr (detail::HasPartialReadMeasurement<Driver>::value)
+        {
+            return sps30.readMeasurement(fields);
+        }
+        else
+        {
+            return sps30.readMeasurement();
+        }
+    }
+
+    // Returns Sps30Error::NotReady if there is no new measurement since the last read.
+    // The UART sensor reports it by the empty reply, so it costs the same as the regular read there.
+    std::variant<Sps30Error, Sps30MeasurementData> readMeasurementIfReady()
+    {
+        if constexpr (detail::HasReadMeasurementIfReady<Driver>::value)
+        {
+            return sps30.readMeasurementIfReady();
+        }
+        else
+        {
+            return sps30.readMeasurement();
+        }
+    }
+
+    // Reads a measurement converted to the unsigned format whatever format the measurement was started in.
+    std::variant<Sps30Error, Sps30MeasurementData> readQuantizedMeasurement()
+    {
+        auto result = sps30.readMeasurement();
+        if (auto data = std::get_if<Sps30MeasurementData>(&result))
+        {
+            *data = quantizeMeasurement(*data);
+        }
+        return result;
+    }
+
+    Sps30Error sleep() { return sps30.sleep(); }
+
+    Sps30Error wakeUp() { return sps30.wakeUp(); }
+
+    Sps30Error resetSensor() { return sps30.resetSensor(); }
+
+    std::variant<Sps30Error, uint32_t> getFanAutoCleaningInterval() { return sps30.getFanAutoCleaningInterval(); }
+
+    Sps30Error setFanAutoCleaningInterval(uint32_t intervalSeconds)
+    {
+        return sps30.setFanAutoCleaningInterval(intervalSeconds);
+    }
+
+    Sps30Error startManualFanCleaning() { return sps30.startManualFanCleaning(); }
+
+private:
+    Driver &sps30;
+};
+
+}
@@ -1,6 +1,7 @@
 #include <cstring>
 #include "EndianConversion.h"
 #include "Sps30Uart.h"
+#include "Sps30MeasurementCodec.h"
 #include "ShdlcTransport.h"
 #include "PacketUart.h"
 #include "Delays.h"
@@ -9,6 +10,27 @@
 namespace
 {
     constexpr uint8_t sps30ShdlcAddr = 0x00;
+
+    template<uint8_t cmd, uint8_t... data>
+    constexpr auto sps30Frame = embedded::makeShdlcFrame<sps30ShdlcAddr, cmd, data...>();
+
+    // Commands with constant parameters are sent as precomputed frames
+    constexpr auto startMeasurementFloatFrame = sps30Frame<0x00, 0x01, 0x03>;
+    constexpr auto startMeasurementIntegerFrame = sps30Frame<0x00, 0x01, 0x05>;
+    constexpr auto stopMeasurementFrame = sps30Frame<0x01>;
+    constexpr auto readMeasurementFrame = sps30Frame<0x03>;
+    constexpr auto sleepFrame = sps30Frame<0x10>;
+    constexpr auto wakeUpFrame = sps30Frame<0x11>;
+    constexpr auto startFanCleaningFrame = sps30Frame<0x56>;
+    constexpr auto readAutoCleaningIntervalFrame = sps30Frame<0x80, 0x00>;
+    constexpr auto readProductTypeFrame = sps30Frame<0xd0, 0x00>;
+    constexpr auto readSerialNumberFrame = sps30Frame<0xd0, 0x03>;
+    constexpr auto readVersionFrame = sps30Frame<0xd1>;
+    constexpr auto resetFrame = sps30Frame<0xd3>;
+
+    // the datasheet example: 7E 00 00 02 01 03 F9 7E
+    static_assert(startMeasurementFloatFrame.size() == 8 && startMeasurementFloatFrame[6] == 0xf9,
+                  "SHDLC frame encoding mismatch with the datasheet example");
 }
 
 namespace embedded
@@ -18,9 +40,8 @@ Sps30Error Sps30Uart::probe()
 {
     wakeUp();
     char serial[maxDeviceInformationlLength];
-    uint8_t paramBuf[] = { 0x00 }; // Get product type
-    const auto result = transport.sendAndReceive(sps30ShdlcAddr, 0xd0, paramBuf,
-                                    { (uint8_t*)serial, maxDeviceInformationlLength });
+    const auto result = transport.sendFrameAndReceive(readProductTypeFrame,
+                                                      { (uint8_t*)serial, maxDeviceInformationlLength });
     if (result == Sps30Error::Success)
     {
         if (std::strcmp(serial, "00080000") != 0)
@@ -33,78 +54,38 @@ Sps30Error Sps30Uart::probe()
 
 Sps30Error Sps30Uart::getSerial(Sps30SerialNumber &serial)
 {
-    uint8_t paramBuf[] = { 0x03 }; // Get serial number
     BytesView serialView { reinterpret_cast<unsigned char*>(serial.serial), sizeof(serial.serial) };
-    return transport.sendAndReceive(sps30ShdlcAddr, 0xd0, paramBuf, serialView);
+    return transport.sendFrameAndReceive(readSerialNumberFrame, serialView);
 }
 
 Sps30Error Sps30Uart::startMeasurement(bool floating)
 {
-    uint8_t paramBuf[2] = { 0x01, floating ? (uint8_t)0x03u : (uint8_t)0x05u };
-
-    return transport.sendAndReceive(sps30ShdlcAddr, 0x00, paramBuf, {});
+    return transport.sendFrameAndReceive(floating ? ConstBytesView(startMeasurementFloatFrame)
+                                                  : ConstBytesView(startMeasurementIntegerFrame), {});
 }
 
 Sps30Error Sps30Uart::stopMeasurement()
 {
-    return transport.sendAndReceive(
-            sps30ShdlcAddr, 0x01, {}, {});
+    return transport.sendFrameAndReceive(stopMeasurementFrame, {});
 }
 
 std::variant<Sps30Error, Sps30MeasurementData> Sps30Uart::readMeasurement()
 {
-    uint32_t data[10];
-    embedded::BytesView bytesView { (uint8_t*)data, sizeof(data) };
+    uint8_t data[Sps30FloatMeasurementCodec::payloadSize];
+    embedded::BytesView bytesView { data, sizeof(data) };
 
-    const auto transportResult = transport.sendAndReceive(sps30ShdlcAddr, 0x03, {}, bytesView);
+    const auto transportResult = transport.sendFrameAndReceive(readMeasurementFrame, bytesView);
     if (transportResult != Sps30Error::Success)
     {
         return transportResult;
     }
 
-    if (bytesView.size() == 40)
-    {
-        return Sps30MeasurementData {
-                .floatData {
-                    .mc_1p0 = embedded::changeEndianessToFloat(data[0]),
-                    .mc_2p5 = embedded::changeEndianessToFloat(data[1]),
-                    .mc_4p0 = embedded::changeEndianessToFloat(data[2]),
-                    .mc_10p0 = embedded::changeEndianessToFloat(data[3]),
-                    .nc_0p5 = embedded::changeEndianessToFloat(data[4]),
-                    .nc_1p0 = embedded::changeEndianessToFloat(data[5]),
-                    .nc_2p5 = embedded::changeEndianessToFloat(data[6]),
-                    .nc_4p0 = embedded::changeEndianessToFloat(data[7]),
-                    .nc_10p0 = embedded::changeEndianessToFloat(data[8]),
-                    .typical_particle_size = embedded::changeEndianessToFloat(data[9])
-                },
-                .measureInFloat = true
-        };
-    }
-    else if (bytesView.size() == 20)
-    {
-        auto* unsignedData = reinterpret_cast<uint16_t*>(data);
-        return Sps30MeasurementData {
-                .unsignedData {
-                    .mc_1p0 = embedded::changeEndianess(unsignedData[0]),
-                    .mc_2p5 = embedded::changeEndianess(unsignedData[1]),
-                    .mc_4p0 = embedded::changeEndianess(unsignedData[2]),
-                    .mc_10p0 = embedded::changeEndianess(unsignedData[3]),
-                    .nc_0p5 = embedded::changeEndianess(unsignedData[4]),
-                    .nc_1p0 = embedded::changeEndianess(unsignedData[5]),
-                    .nc_2p5 = embedded::changeEndianess(unsignedData[6]),
-                    .nc_4p0 = embedded::changeEndianess(unsignedData[7]),
-                    .nc_10p0 = embedded::changeEndianess(unsignedData[8]),
-                    .typical_particle_size = embedded::changeEndianess(unsignedData[9])
-                },
-                .measureInFloat = false
-        };
-    }
-    return Sps30Error::DataError;
+    return decodeMeasurement(data, bytesView.size());
 }
 
 Sps30Error Sps30Uart::sleep()
 {
-    return transport.sendAndReceive(sps30ShdlcAddr, 0x10, {}, {});
+    return transport.sendFrameAndReceive(sleepFrame, {});
 }
 
 Sps30Error Sps30Uart::wakeUp()
@@ -114,19 +95,17 @@ Sps30Error Sps30Uart::wakeUp()
     {
         return result;
     }
-    return transport.sendAndReceive(sps30ShdlcAddr, 0x11, {}, {});
+    return transport.sendFrameAndReceive(wakeUpFrame, {});
 }
 
 std::variant<Sps30Error, uint32_t> Sps30Uart::getFanAutoCleaningInterval()
 {
-    uint8_t tx_data[] = { 0x00 };
-
     union
     {
         uint32_t data;
         uint8_t bytes[4];
     } data;
-    auto transportResult = transport.sendAndReceive(sps30ShdlcAddr, 0x80, tx_data, data.bytes);
+    auto transportResult = transport.sendFrameAndReceive(readAutoCleaningIntervalFrame, data.bytes);
     if (transportResult == Sps30Error::Success)
     {
         return embedded::changeEndianess(data.data);
@@ -158,14 +137,14 @@ Sps30Error Sps30Uart::setFanAutoCleaningInterval(uint32_t intervalSeconds)
 
 Sps30Error Sps30Uart::startManualFanCleaning()
 {
-    return transport.sendAndReceive(sps30ShdlcAddr, 0x56, {}, {});
+    return transport.sendFrameAndReceive(startFanCleaningFrame, {});
 }
 
 std::variant<Sps30Error, Sps30VersionInformation> Sps30Uart::getVersion()
 {
     uint8_t data[7];
 
-    auto result = transport.sendAndReceive(sps30ShdlcAddr, 0xd1, {}, data);
+    auto result = transport.sendFrameAndReceive(readVersionFrame, data);
     if (result == Sps30Error::Success)
     {
         return Sps30VersionInformation {
@@ -181,7 +160,7 @@ std::variant<Sps30Error, Sps30VersionInformation> Sps30Uart::getVersion()
 
 Sps30Error Sps30Uart::resetSensor()
 {
-    auto result = transport.sendAndReceive(sps30ShdlcAddr, 0xd3, {}, {});
+    auto result = transport.sendFrameAndReceive(resetFrame, {});
     if (result == Sps30Error::Success)
     {
         embedded::delay(100);
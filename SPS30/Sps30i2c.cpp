@@ -1,8 +1,12 @@
 #include "Sps30i2c.h"
+#include "Sps30MeasurementCodec.h"
+#include "Sps30Crc.h"
 #include "EndianConversion.h"
 #include "Delays.h"
 #include "Debug.h"
 
+#include <algorithm>
+
 namespace
 {
 
@@ -27,32 +31,21 @@ constexpr uint16_t StartMeasurementInteger = 0x0500;
 constexpr uint16_t StartStopDelay = 20;
 constexpr uint16_t CommandDelay = 5;
 constexpr uint16_t FlashWriteDalay = 20;
+constexpr uint16_t VersionReadDelay = 20;
+constexpr uint16_t ResetDelay = 200;
+constexpr uint16_t SampleInterval = 1000;
+constexpr uint16_t SampleIntervalTolerance = 50;
+constexpr uint16_t DataReadyPollInterval = 20;
 
-constexpr uint8_t crcLength = 1;
 constexpr uint8_t maxReadBufferSize = 64;
-constexpr uint8_t maxWriteBufferSize = 32;
-constexpr uint8_t I2CBlockSize = 2;
 
-uint8_t calculateSps30Crc(const uint8_t data[2])
-{
-    uint8_t crc = 0xFF;
+// the example from the datasheet
+constexpr uint8_t crcCheckWord[] { 0xBE, 0xEF };
+static_assert(embedded::Sps30Crc::calculate(crcCheckWord) == 0x92, "CRC-8 implementation mismatch");
 
-    for (int i = 0; i < 2; ++i)
-    {
-        crc ^= (data[i]);
-        for (int bit = 8; bit > 0; --bit)
-        {
-            if (crc & 0x80)
-            {
-                crc = (crc << 1) ^ 0x31u;
-            }
-            else
-            {
-                crc = (crc << 1);
-            }
-        }
-    }
-    return crc;
+constexpr uint16_t rawReplySize(uint16_t payloadSize)
+{
+    return payloadSize / embedded::Sps30Crc::wordSize * embedded::Sps30Crc::tripletSize;
 }
 }
 
@@ -68,25 +61,45 @@ Sps30Error Sps30I2C::probe()
 
 std::variant<Sps30Error, Sps30VersionInformation> Sps30I2C::getVersion()
 {
-    std::variant<Sps30Error, Sps30VersionInformation> result;
-    if (auto err = readVersion(); err == Sps30Error::Success)
+    if (auto err = readVersion(); err != Sps30Error::Success)
     {
-        result = Sps30VersionInformation {
-                .firmware_major = firmwareVersion[0],
-                .firmware_minor = firmwareVersion[1],
-                .shdlc= std::nullopt
-        };
+        return err;
     }
-    else
+    return versionInformation();
+}
+
+Sps30VersionInformation Sps30I2C::versionInformation() const
+{
+    return Sps30VersionInformation {
+            .firmware_major = firmwareVersion[0],
+            .firmware_minor = firmwareVersion[1],
+            .shdlc= std::nullopt
+    };
+}
+
+Sps30Error Sps30I2C::readVersion()
+{
+    waitUntilIdle();
+    if (const auto error = waitFor(beginGetVersion()); error != Sps30Error::Success)
     {
-        result = err;
+        return error;
     }
-    return result;
+    return readResponse((uint16_t)SPS30Command::GetFirmwareVersion, firmwareVersion);
 }
 
-Sps30Error Sps30I2C::readVersion()
+Sps30I2C::Deadline Sps30I2C::beginGetVersion()
+{
+    return startCommand((uint16_t)SPS30Command::GetFirmwareVersion, VersionReadDelay);
+}
+
+std::variant<Sps30Error, Sps30VersionInformation> Sps30I2C::completeGetVersion()
 {
-    return sendCommandGetResponce((uint16_t)SPS30Command::GetFirmwareVersion, firmwareVersion, 20);
+    if (auto err = readResponse((uint16_t)SPS30Command::GetFirmwareVersion, firmwareVersion);
+            err != Sps30Error::Success)
+    {
+        return err;
+    }
+    return versionInformation();
 }
 
 Sps30Error Sps30I2C::getSerial(Sps30SerialNumber &serial)
@@ -97,7 +110,17 @@ Sps30Error Sps30I2C::getSerial(Sps30SerialNumber &serial)
 
 Sps30Error Sps30I2C::startMeasurement(bool floating)
 {
-    if (!floating && (readVersion() != Sps30Error::Success || firmwareVersion[0] < 2))
+    if (!floating && readVersion() != Sps30Error::Success)
+    {
+        return Sps30Error::UnsupportedCommand;
+    }
+    waitUntilIdle();
+    return waitFor(beginStartMeasurement(floating));
+}
+
+Sps30I2C::Deadline Sps30I2C::beginStartMeasurement(bool floating)
+{
+    if (!floating && firmwareVersion[0] < 2)
     {
         return Sps30Error::UnsupportedCommand;
     }
@@ -120,105 +143,142 @@ Sps30Error Sps30I2C::startMeasurement(bool floating)
     };
 #pragma pack(pop)
 
-    command.crc = calculateSps30Crc(command.buf+2);
-    DEBUG_LOG("Sending Sps30I2C comand: " << embedded::BytesView(command.buf));
-    if (!sps30Device.sendSync(command.buf, sizeof(command.buf)))
+    command.crc = Sps30Crc::calculate(command.buf+2);
+    auto deadline = startCommand(command.buf, StartStopDelay);
+    if (std::holds_alternative<uint32_t>(deadline))
     {
-        return Sps30Error::TransportError;
+        // the first sample is expected a sample interval after the start,
+        // the tick shouldn't be in the future since the elapsed time is computed as unsigned
+        lastSampleTicks = embedded::getMillisecondTicks();
     }
-
-    embedded::delay(StartStopDelay);
-    return Sps30Error::Success;
+    return deadline;
 }
 
 Sps30Error Sps30I2C::stopMeasurement()
 {
-    if (!sendCommand((uint16_t)SPS30Command::StopMeasurement))
-    {
-        return Sps30Error::TransportError;
-    }
+    waitUntilIdle();
+    return waitFor(beginStopMeasurement());
+}
 
-    embedded::delay(StartStopDelay);
-    return Sps30Error::Success;
+Sps30I2C::Deadline Sps30I2C::beginStopMeasurement()
+{
+    return startCommand((uint16_t)SPS30Command::StopMeasurement, StartStopDelay);
 }
 
-bool Sps30I2C::isDataReady()
+std::variant<Sps30Error, bool> Sps30I2C::isDataReady()
 {
     uint16_t readedFlag;
-    auto result = sendCommandGetResponce((uint16_t)SPS30Command::GetDataReady,
-                                         { reinterpret_cast<uint8_t*>(&readedFlag), sizeof readedFlag });
-    return (result == Sps30Error::Success) && (embedded::changeEndianess(readedFlag) != 0);
+    const auto result = sendCommandGetResponce((uint16_t)SPS30Command::GetDataReady,
+                                               { reinterpret_cast<uint8_t*>(&readedFlag), sizeof readedFlag });
+    if (result != Sps30Error::Success)
+    {
+        return result;
+    }
+    return embedded::changeEndianess(readedFlag) != 0;
 }
 
-std::variant<Sps30Error, Sps30MeasurementData> Sps30I2C::readMeasurement()
+std::variant<Sps30Error, Sps30MeasurementData> Sps30I2C::readMeasurementIfReady(Sps30MeasurementFields fields)
 {
-    if (measurementInFloat)
+    // the sensor updates its measurement once per second, so there is no reason to ask it earlier
+    if (embedded::getMillisecondTicks() - lastSampleTicks < SampleInterval - SampleIntervalTolerance)
     {
-        union
+        return Sps30Error::NotReady;
+    }
+
+    const auto ready = isDataReady();
+    if (const auto error = std::get_if<Sps30Error>(&ready))
+    {
+        return *error;
+    }
+    if (!std::get<bool>(ready))
+    {
+        return Sps30Error::NotReady;
+    }
+    return readMeasurement(fields);
+}
+
+std::variant<Sps30Error, Sps30MeasurementData> Sps30I2C::waitForNewSample(uint32_t timeoutMs,
+                                                                         Sps30MeasurementFields fields)
+{
+    const uint32_t startTicks = embedded::getMillisecondTicks();
+    for (;;)
+    {
+        auto result = readMeasurementIfReady(fields);
+        if (const auto error = std::get_if<Sps30Error>(&result); !error || *error != Sps30Error::NotReady)
+        {
+            return result;
+        }
+
+        const uint32_t now = embedded::getMillisecondTicks();
+        const uint32_t elapsed = now - startTicks;
+        if (elapsed >= timeoutMs)
         {
-            uint32_t dwords[10];
-            uint8_t bytes[40];
-        } data;
-        const auto error = sendCommandGetResponce((uint16_t)SPS30Command::ReadMeasurement,
-                                                  data.bytes);
+            return Sps30Error::NotReady;
+        }
 
-        if (error == Sps30Error::Success)
+        uint32_t pause = DataReadyPollInterval;
+        if (const uint32_t sinceLastSample = now - lastSampleTicks;
+                sinceLastSample < SampleInterval - SampleIntervalTolerance)
         {
-            return Sps30MeasurementData {
-                    .floatData {
-                            .mc_1p0 = embedded::changeEndianessToFloat(data.dwords[0]),
-                            .mc_2p5 = embedded::changeEndianessToFloat(data.dwords[1]),
-                            .mc_4p0 = embedded::changeEndianessToFloat(data.dwords[2]),
-                            .mc_10p0 = embedded::changeEndianessToFloat(data.dwords[3]),
-                            .nc_0p5 = embedded::changeEndianessToFloat(data.dwords[4]),
-                            .nc_1p0 = embedded::changeEndianessToFloat(data.dwords[5]),
-                            .nc_2p5 = embedded::changeEndianessToFloat(data.dwords[6]),
-                            .nc_4p0 = embedded::changeEndianessToFloat(data.dwords[7]),
-                            .nc_10p0 = embedded::changeEndianessToFloat(data.dwords[8]),
-                            .typical_particle_size = embedded::changeEndianessToFloat(data.dwords[9])
-                    },
-                    .measureInFloat = true
-            };
+            pause = SampleInterval - SampleIntervalTolerance - sinceLastSample;
         }
+        embedded::delay(std::min(pause, timeoutMs - elapsed));
+    }
+}
+
+std::variant<Sps30Error, Sps30MeasurementData> Sps30I2C::readMeasurement(Sps30MeasurementFields fields)
+{
+    // the reply is received and validated in place, the payload is decoded directly from the receive buffer
+    // the sensor allows to stop reading after any word, so only the requested fields are transferred
+    uint8_t data[rawReplySize(Sps30FloatMeasurementCodec::payloadSize)];
+    const uint8_t payloadSize = measurementInFloat ? Sps30FloatMeasurementCodec::payloadSizeOf(fields)
+                                                   : Sps30UnsignedMeasurementCodec::payloadSizeOf(fields);
+    if (isBusy())
+    {
+        return Sps30Error::NotReady;
+    }
+    if (!sendCommand((uint16_t)SPS30Command::ReadMeasurement))
+    {
+        return Sps30Error::TransportError;
+    }
+    if (const auto error = receiveInplace({ data, rawReplySize(payloadSize) }); error != Sps30Error::Success)
+    {
         return error;
     }
+
+    lastSampleTicks = embedded::getMillisecondTicks();
+    Sps30MeasurementData result;
+    if (measurementInFloat)
+    {
+        Sps30FloatMeasurementCodec::decode(data, result, fields);
+    }
     else
     {
-        union
-        {
-            uint16_t words[10];
-            uint8_t bytes[20];
-        } data;
-        const auto error = sendCommandGetResponce((uint16_t)SPS30Command::ReadMeasurement, data.bytes);
+        Sps30UnsignedMeasurementCodec::decode(data, result, fields);
+    }
+    return result;
+}
 
-        if (error == Sps30Error::Success)
-        {
-            return Sps30MeasurementData {
-                    .unsignedData {
-                            .mc_1p0 = embedded::changeEndianess(data.words[0]),
-                            .mc_2p5 = embedded::changeEndianess(data.words[1]),
-                            .mc_4p0 = embedded::changeEndianess(data.words[2]),
-                            .mc_10p0 = embedded::changeEndianess(data.words[3]),
-                            .nc_0p5 = embedded::changeEndianess(data.words[4]),
-                            .nc_1p0 = embedded::changeEndianess(data.words[5]),
-                            .nc_2p5 = embedded::changeEndianess(data.words[6]),
-                            .nc_4p0 = embedded::changeEndianess(data.words[7]),
-                            .nc_10p0 = embedded::changeEndianess(data.words[8]),
-                            .typical_particle_size = embedded::changeEndianess(data.words[9])
-                    },
-                    .measureInFloat = false
-            };
-        }
+std::variant<Sps30Error, uint32_t> Sps30I2C::getFanAutoCleaningInterval()
+{
+    waitUntilIdle();
+    if (const auto error = waitFor(beginGetFanAutoCleaningInterval()); error != Sps30Error::Success)
+    {
         return error;
     }
+    return completeGetFanAutoCleaningInterval();
 }
 
-std::variant<Sps30Error, uint32_t> Sps30I2C::getFanAutoCleaningInterval()
+Sps30I2C::Deadline Sps30I2C::beginGetFanAutoCleaningInterval()
+{
+    return startCommand((uint16_t)SPS30Command::AutocleanInterval, CommandDelay);
+}
+
+std::variant<Sps30Error, uint32_t> Sps30I2C::completeGetFanAutoCleaningInterval()
 {
     uint32_t data;
-    const auto result =
-            sendCommandGetResponce((uint16_t)SPS30Command::AutocleanInterval,
-                                   { reinterpret_cast<uint8_t*>(&data), sizeof(data) }, CommandDelay);
+    const auto result = readResponse((uint16_t)SPS30Command::AutocleanInterval,
+                                     { reinterpret_cast<uint8_t*>(&data), sizeof(data) });
     if (result == Sps30Error::Success)
     {
         return embedded::changeEndianess(data);
@@ -228,94 +288,120 @@ std::variant<Sps30Error, uint32_t> Sps30I2C::getFanAutoCleaningInterval()
 }
 
 Sps30Error Sps30I2C::setFanAutoCleaningInterval(uint32_t interval_seconds)
+{
+    waitUntilIdle();
+    return waitFor(beginSetFanAutoCleaningInterval(interval_seconds));
+}
+
+Sps30I2C::Deadline Sps30I2C::beginSetFanAutoCleaningInterval(uint32_t intervalSeconds)
 {
     union
     {
         uint32_t seconds;
         uint16_t tmp[2];
-    } converter { embedded::changeEndianess(interval_seconds) };
+    } converter { embedded::changeEndianess(intervalSeconds) };
     uint8_t buf[8];
     *((uint16_t*)buf) = embedded::changeEndianess((uint16_t)SPS30Command::AutocleanInterval);
     *((uint16_t*)(buf + 2)) = converter.tmp[0];
-    buf[4] = calculateSps30Crc(buf + 2);
+    buf[4] = Sps30Crc::calculate(buf + 2);
     *((uint16_t*)(buf + 5)) = converter.tmp[1];
-    buf[7] = calculateSps30Crc(buf + 5);
-    DEBUG_LOG("Sending Sps30I2C comand: " << embedded::BytesView(buf, sizeof(buf)));
-    if (!sps30Device.sendSync(buf, sizeof(buf)))
-    {
-        return Sps30Error::TransportError;
-    }
-
-    embedded::delay(FlashWriteDalay);
-    return Sps30Error::Success;
+    buf[7] = Sps30Crc::calculate(buf + 5);
+    return startCommand(buf, FlashWriteDalay);
 }
 
 Sps30Error Sps30I2C::startManualFanCleaning()
 {
-    if (!sendCommand((uint16_t)SPS30Command::StartManualFanCleaning))
-    {
-        return Sps30Error::TransportError;
-    }
+    waitUntilIdle();
+    return waitFor(beginStartManualFanCleaning());
+}
 
-    embedded::delay(CommandDelay);
-    return Sps30Error::Success;
+Sps30I2C::Deadline Sps30I2C::beginStartManualFanCleaning()
+{
+    return startCommand((uint16_t)SPS30Command::StartManualFanCleaning, CommandDelay);
 }
 
 Sps30Error Sps30I2C::resetSensor()
 {
-    if (!sendCommand((uint16_t)SPS30Command::Reset))
-    {
-        return Sps30Error::TransportError;
-    }
-    embedded::delay(200);
-    return Sps30Error::Success;
+    waitUntilIdle();
+    return waitFor(beginResetSensor());
+}
+
+Sps30I2C::Deadline Sps30I2C::beginResetSensor()
+{
+    return startCommand((uint16_t)SPS30Command::Reset, ResetDelay);
 }
 
 Sps30Error Sps30I2C::sleep()
 {
-    if (readVersion() != Sps30Error::Success || firmwareVersion[0] < 2)
+    // the bus errors are reported as they are, only the old firmware makes the command unsupported
+    if (const auto error = readVersion(); error != Sps30Error::Success)
     {
-        return Sps30Error::UnsupportedCommand;
+        return error;
     }
-    if (!sendCommand((uint16_t)SPS30Command::Sleep))
+    waitUntilIdle();
+    return waitFor(beginSleep());
+}
+
+Sps30I2C::Deadline Sps30I2C::beginSleep()
+{
+    if (firmwareVersion[0] < 2)
     {
-        return Sps30Error::TransportError;
+        return Sps30Error::UnsupportedCommand;
     }
-
-    embedded::delay(CommandDelay);
-    return Sps30Error::Success;
+    return startCommand((uint16_t)SPS30Command::Sleep, CommandDelay);
 }
 
 Sps30Error Sps30I2C::wakeUp()
+{
+    waitUntilIdle();
+    return waitFor(beginWakeUp());
+}
+
+Sps30I2C::Deadline Sps30I2C::beginWakeUp()
 {
     if (firmwareVersion[0] < 0x2)
     { //Allow to try if the version is unknown yet
         return Sps30Error::UnsupportedCommand;
     }
-    sendCommand((uint16_t)SPS30Command::WakeUp); // workaround of I2C initiate sequence
-    if (!sendCommand((uint16_t)SPS30Command::WakeUp))
+    if (isBusy())
     {
-        return Sps30Error::TransportError;
+        return Sps30Error::NotReady;
     }
-
-    embedded::delay(CommandDelay);
-    return Sps30Error::Success;
+    sendCommand((uint16_t)SPS30Command::WakeUp); // workaround of I2C initiate sequence
+    return startCommand((uint16_t)SPS30Command::WakeUp, CommandDelay);
 }
 
 std::variant<Sps30Error, uint32_t> Sps30I2C::readDeviceStatusRegister()
 {
-    if (readVersion() != Sps30Error::Success || firmwareVersion[0] < 2 || firmwareVersion[1] < 2)
+    if (readVersion() != Sps30Error::Success)
     {
         return Sps30Error::UnsupportedCommand;
     }
+    waitUntilIdle();
+    if (const auto error = waitFor(beginReadDeviceStatusRegister()); error != Sps30Error::Success)
+    {
+        return error;
+    }
+    return completeReadDeviceStatusRegister();
+}
+
+Sps30I2C::Deadline Sps30I2C::beginReadDeviceStatusRegister()
+{
+    if (firmwareVersion[0] < 2 || firmwareVersion[1] < 2)
+    {
+        return Sps30Error::UnsupportedCommand;
+    }
+    return startCommand((uint16_t)SPS30Command::ReadDeviceStatusReg, CommandDelay);
+}
 
+std::variant<Sps30Error, uint32_t> Sps30I2C::completeReadDeviceStatusRegister()
+{
     union
     {
         uint32_t value;
         uint8_t bytes[4];
     } value;
-    const auto result = sendCommandGetResponce((uint16_t)SPS30Command::ReadDeviceStatusReg,
-                                               value.bytes, CommandDelay);
+    const auto result = readResponse((uint16_t)SPS30Command::ReadDeviceStatusReg, value.bytes);
     if (result == Sps30Error::Success)
     {
         return embedded::changeEndianess(value.value);
@@ -325,43 +411,122 @@ std::variant<Sps30Error, uint32_t> Sps30I2C::readDeviceStatusRegister()
 
 Sps30Error Sps30I2C::clearDeviceStatusRegister()
 {
-    if (readVersion() != Sps30Error::Success || firmwareVersion[0] < 2)
+    if (readVersion() != Sps30Error::Success)
     {
         return Sps30Error::UnsupportedCommand;
     }
-    if (sendCommand((uint16_t)SPS30Command::ReadDeviceStatusReg))
+    waitUntilIdle();
+    return waitFor(beginClearDeviceStatusRegister());
+}
+
+Sps30I2C::Deadline Sps30I2C::beginClearDeviceStatusRegister()
+{
+    if (firmwareVersion[0] < 2)
     {
-        embedded::delay(CommandDelay);
-        return Sps30Error::Success;
+        return Sps30Error::UnsupportedCommand;
     }
-    return Sps30Error::TransportError;
+    return startCommand((uint16_t)SPS30Command::ReadDeviceStatusReg, CommandDelay);
 }
 
-Sps30Error Sps30I2C::readBytesWithCRC(const BytesView bytes)
+bool Sps30I2C::isBusy() const
 {
-    const auto readSize = static_cast<uint16_t>(bytes.size() * (1 + crcLength / I2CBlockSize));
-    uint8_t buf8[maxReadBufferSize];
+    return int32_t(busyUntilTicks - embedded::getMillisecondTicks()) > 0;
+}
 
-    if (!sps30Device.receiveSync(buf8, readSize))
+Sps30I2C::Deadline Sps30I2C::startCommand(uint16_t command, uint16_t delayMs)
+{
+    // the sensor doesn't accept a new command while processing the previous one
+    if (isBusy())
+    {
+        return Sps30Error::NotReady;
+    }
+    if (!sendCommand(command))
     {
         return Sps30Error::TransportError;
     }
-    DEBUG_LOG("Recieved " << (int)readSize << " bytes from I2C:" << embedded::BytesView(buf8, readSize))
+    busyUntilTicks = embedded::getMillisecondTicks() + delayMs;
+    return busyUntilTicks;
+}
 
-    auto data = bytes.begin();
-    for (uint16_t i = 0, j = 0; i < readSize && j < bytes.size(); ++i)
+Sps30I2C::Deadline Sps30I2C::startCommand(ConstBytesView commandBytes, uint16_t delayMs)
+{
+    if (isBusy())
     {
-        auto crc = calculateSps30Crc(&buf8[i]);
-        if (crc != buf8[i + I2CBlockSize])
-        {
-            DEBUG_LOG("Calculated CRC is " << crc << ", expected " << buf8[i + I2CBlockSize])
-            return Sps30Error::DataError;
-        }
+        return Sps30Error::NotReady;
+    }
+    DEBUG_LOG("Sending Sps30I2C comand: " << commandBytes);
+    if (!sps30Device.sendSync(commandBytes.begin(), commandBytes.size()))
+    {
+        return Sps30Error::TransportError;
+    }
+    lastCommand = uint16_t(commandBytes.begin()[0] << 8 | commandBytes.begin()[1]);
+    busyUntilTicks = embedded::getMillisecondTicks() + delayMs;
+    return busyUntilTicks;
+}
+
+Sps30Error Sps30I2C::waitFor(const Deadline &deadline)
+{
+    if (const auto error = std::get_if<Sps30Error>(&deadline))
+    {
+        return *error;
+    }
+    waitUntilIdle();
+    return Sps30Error::Success;
+}
+
+void Sps30I2C::waitUntilIdle()
+{
+    // the delay may return earlier than requested, so it's repeated until the sensor is ready
+    while (isBusy())
+    {
+        embedded::delay(busyUntilTicks - embedded::getMillisecondTicks());
+    }
+}
+
+Sps30Error Sps30I2C::readResponse(uint16_t command, const BytesView bytes)
+{
+    if (isBusy())
+    {
+        return Sps30Error::NotReady;
+    }
+    // the sensor would reply to another command
+    if (command != lastCommand)
+    {
+        return Sps30Error::DataError;
+    }
+    return readBytesWithCRC(bytes);
+}
+
+Sps30Error Sps30I2C::readBytesWithCRC(const BytesView bytes)
+{
+    const auto readSize = rawReplySize(bytes.size());
+    uint8_t buf8[maxReadBufferSize];
+    if (readSize > sizeof(buf8))
+    {
+        return Sps30Error::DataError;
+    }
+
+    if (const auto result = receiveInplace({ buf8, readSize }); result != Sps30Error::Success)
+    {
+        return result;
+    }
+    std::copy_n(buf8, bytes.size(), bytes.begin());
+    return Sps30Error::Success;
+}
 
-        data[j++] = buf8[i++];
-        data[j++] = buf8[i++];
+Sps30Error Sps30I2C::receiveInplace(const BytesView buffer)
+{
+    if (!sps30Device.receiveSync(buffer.begin(), buffer.size()))
+    {
+        return Sps30Error::TransportError;
     }
+    DEBUG_LOG("Recieved " << (int)buffer.size() << " bytes from I2C:" << buffer)
 
+    if (!Sps30Crc::compactReply(buffer.begin(), buffer.size()))
+    {
+        DEBUG_LOG("CRC mismatch in the reply")
+        return Sps30Error::DataError;
+    }
     return Sps30Error::Success;
 }
 
@@ -373,19 +538,24 @@ bool Sps30I2C::sendCommand(uint16_t command)
         uint8_t bytes[2];
     } cmd { .cmd = embedded::changeEndianess(command) };
     DEBUG_LOG("Sending Sps30I2C comand: " << embedded::BytesView(cmd.bytes))
-    return sps30Device.sendSync(cmd.bytes, sizeof(cmd.bytes));
+    if (!sps30Device.sendSync(cmd.bytes, sizeof(cmd.bytes)))
+    {
+        return false;
+    }
+    lastCommand = command;
+    return true;
 }
 
-Sps30Error Sps30I2C::sendCommandGetResponce(uint16_t cmd, const embedded::BytesView bytes, uint32_t delay_ms)
+// The reading commands don't wait for the command started by a begin* method
+Sps30Error Sps30I2C::sendCommandGetResponce(uint16_t cmd, const embedded::BytesView bytes)
 {
-    if (!sendCommand(cmd))
+    if (isBusy())
     {
-        return Sps30Error::TransportError;
+        return Sps30Error::NotReady;
     }
-
-    if (delay_ms)
+    if (!sendCommand(cmd))
     {
-        embedded::delay(delay_ms);
+        return Sps30Error::TransportError;
     }
     return readBytesWithCRC(bytes);
 }
@@ -24,7 +24,16 @@ public:
 
     Sps30Error startMeasurement(bool floating = true);
     Sps30Error stopMeasurement();
-    std::variant<Sps30Error, Sps30MeasurementData> readMeasurement();
+    // Only the requested leading subset of the values is transferred, the rest of the values are zeroed.
+    std::variant<Sps30Error, Sps30MeasurementData> readMeasurement(
+            Sps30MeasurementFields fields = Sps30MeasurementFields::All);
+    std::variant<Sps30Error, bool> isDataReady();
+    // Reads a measurement only if the sensor reports a new one, returns Sps30Error::NotReady otherwise.
+    std::variant<Sps30Error, Sps30MeasurementData> readMeasurementIfReady(
+            Sps30MeasurementFields fields = Sps30MeasurementFields::All);
+    // Waits for the next sample following the sensor's 1 Hz cadence, returns Sps30Error::NotReady on timeout.
+    std::variant<Sps30Error, Sps30MeasurementData> waitForNewSample(
+            uint32_t timeoutMs = 2000, Sps30MeasurementFields fields = Sps30MeasurementFields::All);
 
     Sps30Error sleep();
     Sps30Error wakeUp();
@@ -37,16 +46,53 @@ public:
     std::variant<Sps30Error, uint32_t> readDeviceStatusRegister();
     Sps30Error clearDeviceStatusRegister();
 
+    // Delay-free command API: every begin* method sends the command at once and returns the tick
+    // when the sensor is ready to accept the next command or to provide the response.
+    // The response is fetched by the matching complete* method which returns Sps30Error::NotReady before that tick
+    // and Sps30Error::DataError if another command was issued after the begin* one.
+    // While the sensor is busy the begin* methods and the reading ones (getSerial, readMeasurement, isDataReady)
+    // return Sps30Error::NotReady, the blocking methods wait.
+    // Firmware version checks use the version cached by probe() or getVersion().
+    // The blocking methods above are the same commands followed by the delay until the returned tick.
+    using Deadline = std::variant<Sps30Error, uint32_t>;
+
+    Deadline beginStartMeasurement(bool floating = true);
+    Deadline beginStopMeasurement();
+    Deadline beginSleep();
+    Deadline beginWakeUp();
+    Deadline beginResetSensor();
+    Deadline beginSetFanAutoCleaningInterval(uint32_t intervalSeconds);
+    Deadline beginStartManualFanCleaning();
+    Deadline beginClearDeviceStatusRegister();
+
+    Deadline beginGetVersion();
+    std::variant<Sps30Error, Sps30VersionInformation> completeGetVersion();
+    Deadline beginGetFanAutoCleaningInterval();
+    std::variant<Sps30Error, uint32_t> completeGetFanAutoCleaningInterval();
+    Deadline beginReadDeviceStatusRegister();
+    std::variant<Sps30Error, uint32_t> completeReadDeviceStatusRegister();
+
+    bool isBusy() const;
+
 private:
-    bool isDataReady();
     Sps30Error readVersion();
+    Sps30VersionInformation versionInformation() const;
+    Deadline startCommand(uint16_t command, uint16_t delayMs);
+    Deadline startCommand(ConstBytesView commandBytes, uint16_t delayMs);
+    Sps30Error waitFor(const Deadline &deadline);
+    void waitUntilIdle();
+    Sps30Error readResponse(uint16_t command, BytesView bytes);
     bool sendCommand(uint16_t command);
-    Sps30Error sendCommandGetResponce(uint16_t cmd, BytesView bytes, uint32_t delay_ms = 0);
+    Sps30Error sendCommandGetResponce(uint16_t cmd, BytesView bytes);
     Sps30Error readBytesWithCRC(BytesView bytes);
+    Sps30Error receiveInplace(BytesView buffer);
 
     embedded::I2CDevice sps30Device;
     std::array<uint8_t, 2> firmwareVersion;
     bool measurementInFloat {};
+    uint32_t lastSampleTicks {};
+    uint32_t busyUntilTicks {};
+    uint16_t lastCommand {};
 };
 
 }
@@ -1,67 +1,78 @@
 #pragma once
 
-#include "graphics/BaseGeometry.h"
-#include "MemoryView.h"
+#include "Ssd1677Display.h"
+
+#include <cstdint>
 
 namespace embedded
 {
-class EpdInterface;
 
 // 3,7" 4-grayscale e-paper display
-class Epd3in7Display
+struct Epd3in7Traits
 {
-public:
-    static constexpr int epdWidth = 280;
-    static constexpr int epdHeight = 480;
-    static constexpr embedded::Rect<uint16_t> fullScreenRect =
-            { { 0, 0 }
-              , { epdWidth, epdHeight } };
+    static constexpr uint16_t width = 280;
+    static constexpr uint16_t height = 480;
 
-    enum class RefreshMode
-    {
-        FullBW, PartBW, Full4Gray
-    };
+    static constexpr uint8_t gateScanning = 0x00;
+    static constexpr uint8_t gateVoltage = 0x00;
+    static constexpr uint8_t sourceVoltage[] { 0x41, 0xA8, 0x32 };
+    static constexpr uint8_t dataEntryMode = 0x03;
+    static constexpr uint8_t borderWaveform = 0x01;
+    static constexpr uint8_t booster[] { 0xAE, 0xC7, 0xC3, 0xC0, 0xC0 };
+    static constexpr uint8_t temperatureSensor = 0x80;
+    static constexpr uint8_t vcom = 0x44;
+    static constexpr uint8_t displayOption[] { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x4F, 0xFF, 0xFF, 0xFF, 0xFF };
+    static constexpr uint8_t updateControl = 0xCF;
 
-    explicit Epd3in7Display(embedded::EpdInterface &hal)
-            : hal(hal) {}
+    static constexpr uint32_t partialRefreshMs = 1000;
+    static constexpr uint32_t fullRefreshMs = 4000;
+    static constexpr uint32_t grayRefreshMs = 5000;
 
-    int init() const;
-    void wakeUp() const;
-    void sleep() const;
-    void reset() const;
-    void clear(RefreshMode mode) const;
-    void displayFrame(embedded::ConstBytesView image, RefreshMode mode = RefreshMode::FullBW) const;
-    void displayWindow(embedded::ConstBytesView image,
-                       embedded::Rect<uint16_t> rect,
-                       RefreshMode mode = RefreshMode::PartBW) const;
-    void waitUntilIdle() const;
+    static constexpr uint8_t lutFull4Gray[] {
+        0x2A, 0x06, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//1
+        0x28, 0x06, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//2
+        0x20, 0x06, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//3
+        0x14, 0x06, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//4
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//5
+        0x00, 0x02, 0x02, 0x0A, 0x00, 0x00, 0x00, 0x08, 0x08, 0x02,//6
+        0x00, 0x02, 0x02, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//7
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//8
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//9
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//10
+        0x22, 0x22, 0x22, 0x22, 0x22
+    };
 
-private:
-    void loadLut(RefreshMode mode) const;
-    void sendCommand(uint8_t command) const;
-    void sendCommand(uint8_t command, uint8_t arg) const
-    {
-        sendCommand(command);
-        sendData(arg);
-    }
+    static constexpr uint8_t lutFullBW[] {
+        0x2A, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//1
+        0x05, 0x2A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//2
+        0x2A, 0x15, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//3
+        0x05, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//4
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//5
+        0x00, 0x02, 0x03, 0x0A, 0x00, 0x02, 0x06, 0x0A, 0x05, 0x00,//6
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//7
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//8
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//9
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,//10
+        0x22, 0x22, 0x22, 0x22, 0x22
+    };
 
-    void sendCommand(uint8_t command, embedded::ConstBytesView data) const
-    {
-        sendCommand(command);
-        sendData(data);
-    }
+    static constexpr uint8_t lutPartBW[] {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //1
+        0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //2
+        0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //3
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //4
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //5
+        0x00, 0x00, 0x03, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //6
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //7
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //8
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //9
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, //10
+        0x22, 0x22, 0x22, 0x22, 0x22
+    };
+};
 
-    void sendData(unsigned char data) const;
-    void sendData(embedded::ConstBytesView data) const;
-    void sendStartPoint(embedded::Point<uint16_t> point) const;
-    void sendAxisLimits(embedded::Rect<uint16_t> rect) const;
-    void prepareToSendScreenData(embedded::Rect<uint16_t> rectToBeSent) const;
-    void sendRectDataBW(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const;
-    void sendRectData4Gray(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const;
-    void send4GrayOnePlane(const embedded::ConstBytesView &image, const embedded::Rect<uint16_t> &rect, bool first) const;
-    void applyAndWait() const;
+using Epd3in7Display = Ssd1677Display<Epd3in7Traits>;
 
-    embedded::EpdInterface &hal;
-};
+extern template class Ssd1677Display<Epd3in7Traits>;
 
-}
\ No newline at end of file
+}
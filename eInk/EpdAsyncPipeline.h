@@ -0,0 +1,266 @@
+#pragma once
+
+#include "EpdInterface.h"
+#include "SpiDevice.h"
+#include "MemoryView.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace embedded
+{
+
+// Double-buffered asynchronous transfer of the display commands and data.
+// While one buffer is being clocked out the caller fills the other one, the segments are sent strictly
+// in the queued order and the DC pin is switched between them, so commands and data can be mixed freely.
+// The chip select is kept active until the queue is drained.
+// If a transfer can't be started or fails when it's completed the queued segments are dropped,
+// the next ones are ignored and flush() returns false.
+// AsyncSpi should provide:
+//     bool startTransfer(const uint8_t *data, uint16_t size);
+//     bool isTransferComplete() const;
+//     bool transferFailed() const; // the status of the completed transfer
+template<typename AsyncSpi, uint16_t bufferSize, uint8_t queueSize>
+class EpdAsyncPipeline
+{
+public:
+    static constexpr uint16_t stripBufferSize = bufferSize;
+
+    EpdAsyncPipeline(const EpdInterface &epd, AsyncSpi &spi)
+            : epd(epd)
+              , spi(spi) {}
+
+    EpdAsyncPipeline(const EpdAsyncPipeline &) = delete;
+
+    ~EpdAsyncPipeline()
+    {
+        flush();
+    }
+
+    // Returns the buffer for the next data segment, waits if both of them are still queued
+    embedded::BytesView acquireBuffer()
+    {
+        while (bufferQueued[nextBuffer])
+        {
+            poll();
+        }
+        return buffers[nextBuffer];
+    }
+
+    // Queues the first size bytes of the buffer returned by acquireBuffer()
+    void queueData(uint16_t size)
+    {
+        bufferQueued[nextBuffer] = true;
+        push({ buffers[nextBuffer].data(), size, 0, true, nextBuffer });
+        nextBuffer ^= 1;
+    }
+
+    // Data which outlives the transfer, e.g. constant tables or frame buffers, is sent without copying
+    void queueData(embedded::ConstBytesView data)
+    {
+        push({ data.begin(), data.size(), 0, true, noBuffer });
+    }
+
+    void queueCommand(uint8_t command)
+    {
+        push({ nullptr, 1, command, false, noBuffer });
+    }
+
+    // Starts the next segment if the current one is complete, returns true when everything is sent
+    bool poll()
+    {
+        if (transferActive)
+        {
+            if (!spi.isTransferComplete())
+            {
+                return false;
+            }
+            transferActive = false;
+            if (spi.transferFailed())
+            {
+                abort();
+                return true;
+            }
+            if (const auto buffer = queue[head].buffer; buffer != noBuffer)
+            {
+                bufferQueued[buffer] = false;
+            }
+            head = (head + 1) % queueSize;
+            --length;
+        }
+        if (length == 0)
+        {
+            chipSelector.reset();
+            return true;
+        }
+        startTransfer(queue[head]);
+        return false;
+    }
+
+    // Waits until everything is sent, returns false if any transfer has failed since the last flush
+    bool flush()
+    {
+        while (!poll())
+        {
+        }
+        const bool succeeded = !failed;
+        failed = false;
+        return succeeded;
+    }
+
+    bool isIdle() const
+    {
+        return length == 0;
+    }
+
+private:
+    static constexpr uint8_t noBuffer = 0xff;
+
+    struct Segment
+    {
+        const uint8_t *data;
+        uint16_t size;
+        uint8_t command;
+        bool isData;
+        uint8_t buffer;
+    };
+
+    void push(const Segment &segment)
+    {
+        if (failed)
+        {
+            // the released buffer can be acquired again
+            if (segment.buffer != noBuffer)
+            {
+                bufferQueued[segment.buffer] = false;
+            }
+            return;
+        }
+        while (length == queueSize)
+        {
+            poll();
+        }
+        queue[(head + length) % queueSize] = segment;
+        ++length;
+        if (!transferActive)
+        {
+            poll();
+        }
+    }
+
+    void startTransfer(const Segment &segment)
+    {
+        if (!chipSelector)
+        {
+            chipSelector.emplace(epd.csPin);
+        }
+        epd.setDcPin(segment.isData);
+        // the command byte stays in the queue until the transfer is complete
+        if (spi.startTransfer(segment.isData ? segment.data : &segment.command, segment.size))
+        {
+            transferActive = true;
+            return;
+        }
+        abort();
+    }
+
+    void abort()
+    {
+        failed = true;
+        length = 0;
+        bufferQueued[0] = bufferQueued[1] = false;
+        chipSelector.reset();
+    }
+
+    const EpdInterface &epd;
+    AsyncSpi &spi;
+    std::optional<embedded::ChipSelector> chipSelector;
+    std::array<uint8_t, bufferSize> buffers[2];
+    bool bufferQueued[2] {};
+    uint8_t nextBuffer = 0;
+    std::array<Segment, queueSize> queue;
+    uint8_t head = 0;
+    uint8_t length = 0;
+    bool transferActive = false;
+    bool failed = false;
+};
+
+// Stand-in for the targets and the host builds without an asynchronous SPI driver:
+// the transfer is done synchronously and is always complete, so the pipeline degrades to the blocking mode.
+class BlockingAsyncSpi
+{
+public:
+    explicit BlockingAsyncSpi(const SpiDevice &spiDevice)
+            : spiDevice(spiDevice) {}
+
+    bool startTransfer(const uint8_t *data, uint16_t size)
+    {
+        return spiDevice.sendSync(data, size);
+    }
+
+    bool isTransferComplete() const
+    {
+        return true;
+    }
+
+    // the failure is returned by startTransfer()
+    bool transferFailed() const
+    {
+        return false;
+    }
+
+private:
+    const SpiDevice &spiDevice;
+};
+
+// Host stand-in of a DMA driver: the data is clocked out when the completion is polled pollsToComplete times
+// after the start, so the pipeline reusing a buffer too early sends the wrong data.
+// A failed send is reported by transferFailed() after the completion.
+class DeferredAsyncSpi
+{
+public:
+    explicit DeferredAsyncSpi(const SpiDevice &spiDevice, uint8_t pollsToComplete = 2)
+            : spiDevice(spiDevice)
+              , pollsToComplete(pollsToComplete) {}
+
+    bool startTransfer(const uint8_t *data, uint16_t size)
+    {
+        failed = false;
+        if (pollsToComplete == 0)
+        {
+            return spiDevice.sendSync(data, size);
+        }
+        pending = { data, size };
+        remainingPolls = pollsToComplete;
+        return true;
+    }
+
+    bool isTransferComplete() const
+    {
+        if (remainingPolls == 0)
+        {
+            return true;
+        }
+        if (--remainingPolls == 0)
+        {
+            failed = !spiDevice.sendSync(pending.begin(), pending.size());
+            return true;
+        }
+        return false;
+    }
+
+    bool transferFailed() const
+    {
+        return failed;
+    }
+
+private:
+    const SpiDevice &spiDevice;
+    const uint8_t pollsToComplete;
+    embedded::ConstBytesView pending {};
+    mutable uint8_t remainingPolls = 0;
+    mutable bool failed = false;
+};
+
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "graphics/BaseGeometry.h"
+#include "MemoryView.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace embedded
+{
+
+// Drawing surface in the layout the display expects: rows of packed pixels, the first pixel in the high bits.
+// 1bpp: 0 is black, 1 is white. 2bpp: 0 is black, 3 is white.
+// All the primitives are clipped to the canvas. Horizontal spans are filled by whole bytes between
+// the masked edges, the blits copy whole bytes if the bit offsets are aligned and shift-merge them otherwise.
+template<uint8_t bitsPerPixel, uint16_t width, uint16_t height>
+class EpdCanvas
+{
+    static_assert(bitsPerPixel == 1 || bitsPerPixel == 2, "Only 1bpp and 2bpp are supported");
+
+public:
+    static constexpr uint16_t bytesWidth = (width * bitsPerPixel + 7) / 8;
+    static constexpr uint16_t bufferSize = bytesWidth * height;
+    static constexpr uint8_t maxColor = (1 << bitsPerPixel) - 1;
+
+    embedded::ConstBytesView data() const { return { buffer.data(), bufferSize }; }
+
+    embedded::BytesView data() { return { buffer.data(), bufferSize }; }
+
+    void fill(uint8_t color)
+    {
+        buffer.fill(pattern(color));
+    }
+
+    void setPixel(int16_t x, int16_t y, uint8_t color)
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+        {
+            return;
+        }
+        const auto bit = uint32_t(x) * bitsPerPixel;
+        auto &byte = buffer[y * bytesWidth + bit / 8];
+        const uint8_t shift = 8 - bitsPerPixel - bit % 8;
+        byte = uint8_t((byte & ~(maxColor << shift)) | ((color & maxColor) << shift));
+    }
+
+    uint8_t getPixel(int16_t x, int16_t y) const
+    {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+        {
+            return 0;
+        }
+        const auto bit = uint32_t(x) * bitsPerPixel;
+        return (buffer[y * bytesWidth + bit / 8] >> (8 - bitsPerPixel - bit % 8)) & maxColor;
+    }
+
+    // Fills the pixels from x0 to x1 inclusive
+    void drawHorizontalLine(int16_t x0, int16_t x1, int16_t y, uint8_t color)
+    {
+        if (x0 > x1)
+        {
+            std::swap(x0, x1);
+        }
+        if (y < 0 || y >= height || x1 < 0 || x0 >= width)
+        {
+            return;
+        }
+        x0 = std::max<int16_t>(x0, 0);
+        x1 = std::min<int16_t>(x1, width - 1);
+        fillBits(&buffer[y * bytesWidth], uint32_t(x0) * bitsPerPixel, uint32_t(x1 - x0 + 1) * bitsPerPixel, pattern(color));
+    }
+
+    void drawVerticalLine(int16_t x, int16_t y0, int16_t y1, uint8_t color)
+    {
+        if (y0 > y1)
+        {
+            std::swap(y0, y1);
+        }
+        for (auto y = std::max<int16_t>(y0, 0); y <= std::min<int16_t>(y1, height - 1); ++y)
+        {
+            setPixel(x, y, color);
+        }
+    }
+
+    void drawLine(embedded::Point<int16_t> from, embedded::Point<int16_t> to, uint8_t color)
+    {
+        if (from.y == to.y)
+        {
+            drawHorizontalLine(from.x, to.x, from.y, color);
+            return;
+        }
+        if (from.x == to.x)
+        {
+            drawVerticalLine(from.x, from.y, to.y, color);
+            return;
+        }
+        // Bresenham's algorithm, the pixels of the same row are drawn as one span
+        const int16_t dx = std::abs(to.x - from.x);
+        const int16_t dy = -std::abs(to.y - from.y);
+        const int8_t stepX = from.x < to.x ? 1 : -1;
+        const int8_t stepY = from.y < to.y ? 1 : -1;
+        int32_t error = dx + dy;
+        auto spanStart = from.x;
+        for (auto point = from;;)
+        {
+            const bool last = point.x == to.x && point.y == to.y;
+            const int32_t doubledError = 2 * error;
+            const bool moveX = doubledError >= dy;
+            const bool moveY = doubledError <= dx;
+            if (last || moveY)
+            {
+                drawHorizontalLine(spanStart, point.x, point.y, color);
+            }
+            if (last)
+            {
+                break;
+            }
+            if (moveX)
+            {
+                error += dy;
+                point.x += stepX;
+            }
+            if (moveY)
+            {
+                error += dx;
+                point.y += stepY;
+                spanStart = point.x;
+            }
+        }
+    }
+
+    void fillRect(embedded::Rect<int16_t> rect, uint8_t color)
+    {
+        if (rect.size.width <= 0 || rect.size.height <= 0)
+        {
+            return;
+        }
+        const auto bottomRight = rect.bottomRight();
+        for (auto y = std::max<int16_t>(rect.topLeft.y, 0); y <= std::min<int16_t>(bottomRight.y, height - 1); ++y)
+        {
+            drawHorizontalLine(rect.topLeft.x, bottomRight.x, y, color);
+        }
+    }
+
+    void drawRect(embedded::Rect<int16_t> rect, uint8_t color)
+    {
+        if (rect.size.width <= 0 || rect.size.height <= 0)
+        {
+            return;
+        }
+        const auto bottomRight = rect.bottomRight();
+        drawHorizontalLine(rect.topLeft.x, bottomRight.x, rect.topLeft.y, color);
+        drawHorizontalLine(rect.topLeft.x, bottomRight.x, bottomRight.y, color);
+        drawVerticalLine(rect.topLeft.x, rect.topLeft.y, bottomRight.y, color);
+        drawVerticalLine(bottomRight.x, rect.topLeft.y, bottomRight.y, color);
+    }
+
+    // Copies an image in the canvas format with the rows of (imageWidth * bitsPerPixel + 7) / 8 bytes
+    void blit(embedded::Point<int16_t> position, embedded::ConstBytesView image, uint16_t imageWidth, uint16_t imageHeight)
+    {
+        const uint16_t imageBytesWidth = (imageWidth * bitsPerPixel + 7) / 8;
+        if (image.size() < imageBytesWidth * imageHeight)
+        {
+            return;
+        }
+        const int16_t left = std::max<int16_t>(position.x, 0);
+        const int16_t right = std::min<int32_t>(position.x + imageWidth, width);
+        const int16_t top = std::max<int16_t>(position.y, 0);
+        const int16_t bottom = std::min<int32_t>(position.y + imageHeight, height);
+        if (left >= right || top >= bottom)
+        {
+            return;
+        }
+        const uint32_t sourceBit = uint32_t(left - position.x) * bitsPerPixel;
+        const uint32_t targetBit = uint32_t(left) * bitsPerPixel;
+        const uint32_t bitsCount = uint32_t(right - left) * bitsPerPixel;
+        for (auto y = top; y < bottom; ++y)
+        {
+            copyBits(&buffer[y * bytesWidth], targetBit,
+                     image.begin() + (y - position.y) * imageBytesWidth, sourceBit, bitsCount);
+        }
+    }
+
+private:
+    static constexpr uint8_t pattern(uint8_t color)
+    {
+        return bitsPerPixel == 1 ? (color & 1 ? 0xFF : 0x00) : uint8_t((color & maxColor) * 0x55);
+    }
+
+    // mask of count bits starting from the bit offset in a byte, MSB first
+    static constexpr uint8_t bitsMask(uint8_t offset, uint8_t count)
+    {
+        return uint8_t((0xFF >> offset) & (0xFF << (8 - offset - count)));
+    }
+
+    static void fillBits(uint8_t *row, uint32_t bit, uint32_t count, uint8_t value)
+    {
+        auto index = bit / 8;
+        if (const uint8_t offset = bit % 8; offset)
+        {
+            const uint8_t bits = std::min<uint32_t>(8 - offset, count);
+            const auto mask = bitsMask(offset, bits);
+            row[index] = uint8_t((row[index] & ~mask) | (value & mask));
+            ++index;
+            count -= bits;
+        }
+        std::fill_n(row + index, count / 8, value);
+        if (const uint8_t rest = count % 8; rest)
+        {
+            index += count / 8;
+            const auto mask = bitsMask(0, rest);
+            row[index] = uint8_t((row[index] & ~mask) | (value & mask));
+        }
+    }
+
+    // the 8 bits from the bit position, the source isn't read beyond the end bit
+    static uint8_t loadByte(const uint8_t *source, uint32_t bit, uint32_t endBit)
+    {
+        const auto index = bit / 8;
+        const uint8_t shift = bit % 8;
+        auto value = uint8_t(source[index] << shift);
+        if (shift && (index + 1) * 8 < endBit)
+        {
+            value |= source[index + 1] >> (8 - shift);
+        }
+        return value;
+    }
+
+    static void copyBits(uint8_t *target, uint32_t targetBit, const uint8_t *source, uint32_t sourceBit, uint32_t count)
+    {
+        const auto sourceEnd = sourceBit + count;
+        auto index = targetBit / 8;
+        if (const uint8_t offset = targetBit % 8; offset)
+        {
+            const uint8_t bits = std::min<uint32_t>(8 - offset, count);
+            const auto mask = bitsMask(offset, bits);
+            target[index] = uint8_t((target[index] & ~mask) | ((loadByte(source, sourceBit, sourceEnd) >> offset) & mask));
+            ++index;
+            sourceBit += bits;
+            count -= bits;
+        }
+        if (sourceBit % 8 == 0)
+        {
+            std::memcpy(target + index, source + sourceBit / 8, count / 8);
+            index += count / 8;
+            sourceBit += count / 8 * 8;
+        }
+        else
+        {
+            for (; count >= 8; count -= 8, sourceBit += 8)
+            {
+                target[index++] = loadByte(source, sourceBit, sourceEnd);
+            }
+        }
+        if (const uint8_t rest = count % 8; rest)
+        {
+            const auto mask = bitsMask(0, rest);
+            target[index] = uint8_t((target[index] & ~mask) | (loadByte(source, sourceBit, sourceEnd) & mask));
+        }
+    }
+
+    std::array<uint8_t, bufferSize> buffer {};
+};
+
+}
@@ -8,8 +8,14 @@
 namespace embedded
 {
 
+template<typename AsyncSpi, uint16_t bufferSize, uint8_t queueSize>
+class EpdAsyncPipeline;
+
 class EpdInterface
 {
+    template<typename AsyncSpi, uint16_t bufferSize, uint8_t queueSize>
+    friend class EpdAsyncPipeline;
+
 public:
     EpdInterface(SpiDevice &spiDevice, GpioPinDefinition &resetPin, GpioPinDefinition &dcPin,
                  GpioPinDefinition &csPin, GpioPinDefinition &busyPin)
@@ -33,6 +39,30 @@ public:
         spiDevice.sendSync(buf.begin(), buf.size());
     }
 
+    // Keeps the chip select active and the DC pin in the data state for a series of buffers,
+    // so a whole screen area can be streamed without toggling them for every byte or row.
+    class DataTransfer
+    {
+    public:
+        explicit DataTransfer(const EpdInterface &epd)
+                : epd(epd)
+                  , cs((epd.setDcPin(true), epd.csPin)) {}
+
+        void send(ConstBytesView buf) const
+        {
+            epd.spiDevice.sendSync(buf.begin(), buf.size());
+        }
+
+    private:
+        const EpdInterface &epd;
+        embedded::ChipSelector cs;
+    };
+
+    DataTransfer startDataTransfer() const
+    {
+        return DataTransfer(*this);
+    }
+
     void setDcPin(bool set) const
     {
         dcPin.set(set);
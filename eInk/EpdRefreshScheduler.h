@@ -0,0 +1,162 @@
+#pragma once
+
+#include "Epd3in7Display.h"
+#include "Delays.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace embedded
+{
+
+// Chooses between the fast partial and the clean full refresh of the BW frames.
+// The screen is split into a grid of regions, each one counts the partial refreshes touching it.
+// The full refresh is done when any of the updated regions exceeds the threshold,
+// or from process() when the display has been idle long enough with some ghosting accumulated.
+template<uint8_t gridColumns = 4, uint8_t gridRows = 4, typename Display = Epd3in7Display>
+class EpdRefreshScheduler
+{
+public:
+    using RefreshHandle = typename Display::RefreshHandle;
+    static constexpr uint16_t regionWidth = (Display::epdWidth + gridColumns - 1) / gridColumns;
+    static constexpr uint16_t regionHeight = (Display::epdHeight + gridRows - 1) / gridRows;
+
+    struct Config
+    {
+        uint16_t partialThreshold = 10;
+        uint32_t idleFullRefreshMs = 60000; // 0 disables the idle refresh
+    };
+
+    explicit EpdRefreshScheduler(const Display &display, Config config = {})
+            : display(display)
+              , config(config) {}
+
+    RefreshHandle displayFrame(embedded::ConstBytesView image)
+    {
+        return displayWindow(image, Display::fullScreenRect);
+    }
+
+    RefreshHandle displayWindow(embedded::ConstBytesView image, embedded::Rect<uint16_t> rect)
+    {
+        return displayWindows(image, &rect, 1);
+    }
+
+    RefreshHandle displayWindows(embedded::ConstBytesView image, const embedded::Rect<uint16_t> *rects, uint8_t rectsCount)
+    {
+        bool needsFullRefresh = false;
+        for (uint8_t i = 0; i < rectsCount; ++i)
+        {
+            forEachRegion(rects[i], [&](uint16_t &counter)
+            {
+                needsFullRefresh |= counter + 1 > config.partialThreshold;
+            });
+        }
+        if (needsFullRefresh)
+        {
+            return fullRefresh(image);
+        }
+        auto handle = display.displayWindows(image, rects, rectsCount, Display::RefreshMode::PartBW);
+        // the counters are updated only for the refresh which was really done
+        if (handle.isStarted())
+        {
+            for (uint8_t i = 0; i < rectsCount; ++i)
+            {
+                forEachRegion(rects[i], [](uint16_t &counter) { ++counter; });
+            }
+            ++partialRefreshes;
+            lastUpdateTicks = embedded::getMillisecondTicks();
+        }
+        return handle;
+    }
+
+    template<uint8_t maxRects>
+    RefreshHandle displayChanges(embedded::ConstBytesView image,
+                                 embedded::FrameDiff<Display::epdWidth, Display::epdHeight, maxRects> &diff)
+    {
+        const auto rectsCount = diff.update(image);
+        if (rectsCount == 0)
+        {
+            return {};
+        }
+        auto handle = displayWindows(image, diff.begin(), rectsCount);
+        // the changes didn't reach the panel, the next frame is uploaded completely
+        if (!handle.isStarted())
+        {
+            diff.invalidate();
+        }
+        return handle;
+    }
+
+    // Should be called periodically with the currently displayed frame, does the full refresh on idle
+    RefreshHandle process(embedded::ConstBytesView image)
+    {
+        if (config.idleFullRefreshMs == 0 || maxPartialCount() == 0
+            || embedded::getMillisecondTicks() - lastUpdateTicks < config.idleFullRefreshMs)
+        {
+            return {};
+        }
+        return fullRefresh(image);
+    }
+
+    uint16_t partialCount(uint8_t column, uint8_t row) const
+    {
+        return counters[row * gridColumns + column];
+    }
+
+    uint16_t maxPartialCount() const
+    {
+        return *std::max_element(counters.begin(), counters.end());
+    }
+
+    uint32_t partialRefreshesCount() const { return partialRefreshes; }
+
+    uint32_t fullRefreshesCount() const { return fullRefreshes; }
+
+    // E.g. after the application did the full refresh itself
+    void resetCounters()
+    {
+        counters.fill(0);
+    }
+
+private:
+    RefreshHandle fullRefresh(embedded::ConstBytesView image)
+    {
+        auto handle = display.displayFrame(image, Display::RefreshMode::FullBW);
+        if (handle.isStarted())
+        {
+            resetCounters();
+            ++fullRefreshes;
+            lastUpdateTicks = embedded::getMillisecondTicks();
+        }
+        return handle;
+    }
+
+    template<typename Action>
+    void forEachRegion(const embedded::Rect<uint16_t> &rect, Action action)
+    {
+        if (rect.size.width == 0 || rect.size.height == 0)
+        {
+            return;
+        }
+        const auto bottomRight = rect.bottomRight();
+        const uint8_t lastColumn = std::min<uint16_t>(bottomRight.x / regionWidth, gridColumns - 1);
+        const uint8_t lastRow = std::min<uint16_t>(bottomRight.y / regionHeight, gridRows - 1);
+        for (uint8_t row = rect.topLeft.y / regionHeight; row <= lastRow; ++row)
+        {
+            for (uint8_t column = rect.topLeft.x / regionWidth; column <= lastColumn; ++column)
+            {
+                action(counters[row * gridColumns + column]);
+            }
+        }
+    }
+
+    const Display &display;
+    Config config;
+    std::array<uint16_t, gridColumns * gridRows> counters {};
+    uint32_t lastUpdateTicks = 0;
+    uint32_t partialRefreshes = 0;
+    uint32_t fullRefreshes = 0;
+};
+
+}
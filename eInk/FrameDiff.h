@@ -0,0 +1,155 @@
+#pragma once
+
+#include "graphics/BaseGeometry.h"
+#include "MemoryView.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace embedded
+{
+
+// Keeps the last uploaded 1bpp frame and finds the byte aligned rectangles changed by the next one.
+// Rows are compared word at a time, the changed rows are grouped into bands which are merged
+// while the extra bytes cost less than the commands of a separate rectangle.
+template<uint16_t width, uint16_t height, uint8_t maxRects = 8>
+class FrameDiff
+{
+public:
+    static constexpr uint16_t bytesWidth = width / 8;
+    static_assert(width % 8 == 0, "The frame rows should be byte aligned");
+    static_assert(maxRects > 0, "At least one rectangle is required");
+
+    // The cost of the window, cursor and RAM write commands of one rectangle in the data bytes
+    static constexpr uint16_t rectOverheadBytes = 24;
+
+    // Compares the frame with the previous one and remembers it, returns the number of the changed rectangles.
+    // The first frame after the construction or invalidate() is changed completely.
+    uint8_t update(embedded::ConstBytesView frame)
+    {
+        count = 0;
+        if (frame.size() < previous.size())
+        {
+            return 0;
+        }
+        if (!valid)
+        {
+            std::copy_n(frame.begin(), previous.size(), previous.begin());
+            valid = true;
+            rects[count++] = { { 0, 0 }, { width, height } };
+            return count;
+        }
+
+        Band band {};
+        bool bandOpen = false;
+        for (uint16_t row = 0; row < height; ++row)
+        {
+            const auto offset = row * bytesWidth;
+            uint16_t first;
+            uint16_t last;
+            if (!findRowChanges(frame.begin() + offset, previous.data() + offset, first, last))
+            {
+                continue;
+            }
+            std::copy(frame.begin() + offset + first, frame.begin() + offset + last + 1, previous.begin() + offset + first);
+
+            if (bandOpen && (count + 1 == maxRects || isMergeCheaper(band, row, first, last)))
+            {
+                band.first = std::min(band.first, first);
+                band.last = std::max(band.last, last);
+                band.lastRow = row;
+                continue;
+            }
+            if (bandOpen)
+            {
+                rects[count++] = toRect(band);
+            }
+            band = { first, last, row, row };
+            bandOpen = true;
+        }
+        if (bandOpen)
+        {
+            rects[count++] = toRect(band);
+        }
+        return count;
+    }
+
+    // Makes the next update() report the whole frame, e.g. after the display reset
+    void invalidate() { valid = false; }
+
+    uint8_t size() const { return count; }
+
+    const embedded::Rect<uint16_t> *begin() const { return rects.data(); }
+
+    const embedded::Rect<uint16_t> *end() const { return rects.data() + count; }
+
+private:
+    struct Band
+    {
+        uint16_t first;
+        uint16_t last;
+        uint16_t firstRow;
+        uint16_t lastRow;
+    };
+
+    static uint32_t loadWord(const uint8_t *data)
+    {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        return word;
+    }
+
+    // finds the first and the last changed bytes of the row
+    static bool findRowChanges(const uint8_t *current, const uint8_t *old, uint16_t &first, uint16_t &last)
+    {
+        uint16_t begin = 0;
+        while (begin + 4 <= bytesWidth && loadWord(current + begin) == loadWord(old + begin))
+        {
+            begin += 4;
+        }
+        while (begin < bytesWidth && current[begin] == old[begin])
+        {
+            ++begin;
+        }
+        if (begin == bytesWidth)
+        {
+            return false;
+        }
+        uint16_t end = bytesWidth;
+        while (end >= begin + 4 && loadWord(current + end - 4) == loadWord(old + end - 4))
+        {
+            end -= 4;
+        }
+        while (current[end - 1] == old[end - 1])
+        {
+            --end;
+        }
+        first = begin;
+        last = end - 1;
+        return true;
+    }
+
+    static bool isMergeCheaper(const Band &band, uint16_t row, uint16_t first, uint16_t last)
+    {
+        const uint32_t bandBytes = uint32_t(band.last - band.first + 1) * (band.lastRow - band.firstRow + 1);
+        const uint32_t separateBytes = bandBytes + (last - first + 1) + rectOverheadBytes;
+        const uint32_t mergedBytes = uint32_t(std::max(band.last, last) - std::min(band.first, first) + 1)
+                                     * (row - band.firstRow + 1);
+        return mergedBytes <= separateBytes;
+    }
+
+    static embedded::Rect<uint16_t> toRect(const Band &band)
+    {
+        return { { uint16_t(band.first * 8), band.firstRow },
+                 { uint16_t((band.last - band.first + 1) * 8), uint16_t(band.lastRow - band.firstRow + 1) } };
+    }
+
+    std::array<uint8_t, bytesWidth * height> previous;
+    std::array<embedded::Rect<uint16_t>, maxRects> rects;
+    uint8_t count = 0;
+    bool valid = false;
+};
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "graphics/BaseGeometry.h"
+#include "MemoryView.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace embedded
+{
+
+enum class DitherMode : uint8_t
+{
+    Bayer, ErrorDiffusion
+};
+
+// Row by row conversion of the 8-bit grayscale (0 is black, 255 is white) to the packed 1bpp or 2bpp layout
+// of the display images. The ordered mode uses the 8x8 Bayer matrix, the error diffusion one is
+// the integer Floyd-Steinberg with the errors of the current and the next rows only.
+template<uint8_t bitsPerPixel, uint16_t maxWidth>
+class GrayDitherer
+{
+    static_assert(bitsPerPixel == 1 || bitsPerPixel == 2, "Only 1bpp and 2bpp are supported");
+
+public:
+    static constexpr uint8_t maxLevel = (1 << bitsPerPixel) - 1;
+
+    explicit GrayDitherer(DitherMode mode)
+            : mode(mode) {}
+
+    // Should be called before the first row of every image.
+    // The first row sets the phase of the Bayer pattern, so the images started at different rows line up.
+    void reset(uint16_t firstRow = 0)
+    {
+        row = firstRow;
+        for (auto &rowErrors: errors)
+        {
+            rowErrors.fill(0);
+        }
+    }
+
+    // Converts width pixels of the next row, the output gets (width * bitsPerPixel + 7) / 8 bytes
+    void convertRow(const uint8_t *gray, uint16_t width, uint8_t *output)
+    {
+        width = std::min(width, maxWidth);
+        std::fill_n(output, (width * bitsPerPixel + 7) / 8, 0);
+        if (mode == DitherMode::Bayer)
+        {
+            const auto thresholds = bayerMatrix[row & 7];
+            for (uint16_t x = 0; x < width; ++x)
+            {
+                const uint32_t scaled = uint32_t(gray[x]) * maxLevel * 64 + thresholds[x & 7] * 255u + 127;
+                putPixel(output, x, uint8_t(std::min<uint32_t>(scaled / (255 * 64), maxLevel)));
+            }
+        }
+        else
+        {
+            auto &current = errors[row & 1];
+            auto &next = errors[(row + 1) & 1];
+            next.fill(0);
+            // the error arrays have a guard element on the both sides
+            for (uint16_t x = 0; x < width; ++x)
+            {
+                const int16_t value = int16_t(gray[x] + current[x + 1]);
+                const auto level = quantize(value);
+                putPixel(output, x, level);
+                const int16_t error = int16_t(value - level * (255 / maxLevel));
+                const int16_t right = error * 7 / 16;
+                const int16_t belowLeft = error * 3 / 16;
+                const int16_t below = error * 5 / 16;
+                current[x + 2] += right;
+                next[x] += belowLeft;
+                next[x + 1] += below;
+                next[x + 2] += int16_t(error - right - belowLeft - below);
+            }
+        }
+        ++row;
+    }
+
+    // Makes a renderer for Epd3in7Display::displayStrips.
+    // The source is called as source(uint16_t y, embedded::BytesView grayRow) and should fill grayRow.size() pixels,
+    // the strip is cut to maxWidth pixels and the rest of it is left black.
+    // The renderer restarts the dithering unless the strip continues the previous one, e.g. for the second RAM plane
+    // or the next upload, so the output doesn't depend on what was rendered before.
+    template<typename Source>
+    auto makeStripRenderer(Source source)
+    {
+        return [this, source, nextRow = uint16_t(0)](embedded::BytesView strip,
+                                                     embedded::Rect<uint16_t> stripRect) mutable
+        {
+            // a strip which doesn't continue the previous one starts a new image
+            if (stripRect.topLeft.y != nextRow || nextRow == 0)
+            {
+                reset(stripRect.topLeft.y);
+            }
+            const uint16_t rowBytes = (stripRect.size.width * bitsPerPixel + 7) / 8;
+            const uint16_t width = std::min(stripRect.size.width, maxWidth);
+            const uint16_t convertedBytes = (width * bitsPerPixel + 7) / 8;
+            uint8_t grayRow[maxWidth];
+            for (uint16_t y = 0; y < stripRect.size.height; ++y)
+            {
+                const auto output = strip.begin() + y * rowBytes;
+                source(uint16_t(stripRect.topLeft.y + y), embedded::BytesView { grayRow, width });
+                convertRow(grayRow, width, output);
+                std::fill(output + convertedBytes, output + rowBytes, 0);
+            }
+            nextRow = stripRect.topLeft.y + stripRect.size.height;
+        };
+    }
+
+private:
+    static constexpr uint8_t bayerMatrix[8][8] {
+            { 0, 32, 8, 40, 2, 34, 10, 42 },
+            { 48, 16, 56, 24, 50, 18, 58, 26 },
+            { 12, 44, 4, 36, 14, 46, 6, 38 },
+            { 60, 28, 52, 20, 62, 30, 54, 22 },
+            { 3, 35, 11, 43, 1, 33, 9, 41 },
+            { 51, 19, 59, 27, 49, 17, 57, 25 },
+            { 15, 47, 7, 39, 13, 45, 5, 37 },
+            { 63, 31, 55, 23, 61, 29, 53, 21 },
+    };
+
+    static uint8_t quantize(int16_t value)
+    {
+        if (value <= 0)
+        {
+            return 0;
+        }
+        return uint8_t(std::min<int16_t>((value * maxLevel + 127) / 255, maxLevel));
+    }
+
+    static void putPixel(uint8_t *output, uint16_t x, uint8_t level)
+    {
+        const uint32_t bit = uint32_t(x) * bitsPerPixel;
+        output[bit / 8] |= level << (8 - bitsPerPixel - bit % 8);
+    }
+
+    DitherMode mode;
+    uint16_t row = 0;
+    std::array<std::array<int16_t, maxWidth + 2>, 2> errors {};
+};
+
+}
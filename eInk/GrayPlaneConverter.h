@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace embedded
+{
+
+namespace detail
+{
+
+// Splits 4 packed 2bpp pixels (the first pixel in the high bits) into 4 bits of the both RAM planes:
+// the low nibble takes the low bits of the pixels (0x24 plane), the high nibble takes the high bits (0x26 plane).
+constexpr std::array<uint8_t, 256> makeGrayPlaneTable()
+{
+    std::array<uint8_t, 256> table {};
+    for (unsigned pixels = 0; pixels < 256; ++pixels)
+    {
+        uint8_t lowBits = 0;
+        uint8_t highBits = 0;
+        for (unsigned pixel = 0; pixel < 4; ++pixel)
+        {
+            const auto value = (pixels >> (6 - pixel * 2)) & 0x03;
+            lowBits = (lowBits << 1) | (value & 0x01);
+            highBits = (highBits << 1) | (value >> 1);
+        }
+        table[pixels] = uint8_t(highBits << 4 | lowBits);
+    }
+    return table;
+}
+
+inline constexpr auto grayPlaneTable = makeGrayPlaneTable();
+
+// The mask and shift conversion of one source byte the table has replaced, the 4 plane bits are in the low nibble
+constexpr uint8_t convertGrayNibble(uint8_t pixels, bool lowPlane)
+{
+    auto bits = uint8_t(pixels & (lowPlane ? 0b01010101 : 0b10101010));
+    if (lowPlane)
+    {
+        bits = uint8_t(bits << 1);
+    }
+    return uint8_t(((bits & 0x80) | ((bits << 1) & 0x40) | ((bits << 2) & 0x20) | ((bits << 3) & 0x10)) >> 4);
+}
+
+constexpr bool isGrayPlaneTableValid()
+{
+    for (unsigned pixels = 0; pixels < 256; ++pixels)
+    {
+        for (unsigned shift = 0; shift <= 4; shift += 4)
+        {
+            if (((grayPlaneTable[pixels] >> shift) & 0x0F) != convertGrayNibble(uint8_t(pixels), shift == 0))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static_assert(isGrayPlaneTableValid(), "The gray plane table doesn't match the mask and shift conversion");
+
+}
+
+// Converts a row of packed 2bpp pixels into one of the controller's 1bpp RAM planes.
+// Every two source bytes make one plane byte, an odd trailing source byte fills the high nibble only.
+// Returns the number of the plane bytes.
+inline uint16_t extractGrayPlane(const uint8_t *source, uint16_t sourceBytes, uint8_t *plane, bool lowPlane)
+{
+    const uint8_t shift = lowPlane ? 0 : 4;
+    uint16_t pos = 0;
+    for (; pos + 1 < sourceBytes; pos += 2)
+    {
+        const auto first = (detail::grayPlaneTable[source[pos]] >> shift) & 0x0F;
+        const auto second = (detail::grayPlaneTable[source[pos + 1]] >> shift) & 0x0F;
+        *plane++ = uint8_t(first << 4 | second);
+    }
+    if (pos < sourceBytes)
+    {
+        *plane = uint8_t(((detail::grayPlaneTable[source[pos]] >> shift) & 0x0F) << 4);
+    }
+    return (sourceBytes + 1) / 2;
+}
+
+// Converts a row of packed 2bpp pixels into the both RAM planes in one pass over the source.
+inline uint16_t splitGrayPlanes(const uint8_t *source, uint16_t sourceBytes, uint8_t *lowPlane, uint8_t *highPlane)
+{
+    uint16_t pos = 0;
+    for (; pos + 1 < sourceBytes; pos += 2)
+    {
+        const auto first = detail::grayPlaneTable[source[pos]];
+        const auto second = detail::grayPlaneTable[source[pos + 1]];
+        *lowPlane++ = uint8_t(first << 4 | (second & 0x0F));
+        *highPlane++ = uint8_t((first & 0xF0) | second >> 4);
+    }
+    if (pos < sourceBytes)
+    {
+        const auto first = detail::grayPlaneTable[source[pos]];
+        *lowPlane = uint8_t(first << 4);
+        *highPlane = uint8_t(first & 0xF0);
+    }
+    return (sourceBytes + 1) / 2;
+}
+
+}
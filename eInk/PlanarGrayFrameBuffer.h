@@ -0,0 +1,88 @@
+#pragma once
+
+#include "GrayPlaneConverter.h"
+#include "MemoryView.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace embedded
+{
+
+// 4-grayscale image stored as two 1bpp planes in the layout of the controller RAM:
+// the low plane keeps the low bits of the gray levels (RAM 0x24), the high plane keeps the high ones (RAM 0x26).
+// The levels are the same as in the packed 2bpp images: 0 is black, 3 is white.
+// The planes are uploaded as they are, without any conversion.
+template<uint16_t width, uint16_t height>
+class PlanarGrayFrameBuffer
+{
+public:
+    static constexpr uint16_t bytesWidth = (width + 7) / 8;
+    static constexpr uint16_t planeSize = bytesWidth * height;
+    static_assert(uint32_t(bytesWidth) * height <= UINT16_MAX, "The plane doesn't fit a single transfer");
+
+    void setPixel(uint16_t x, uint16_t y, uint8_t level)
+    {
+        if (x >= width || y >= height)
+        {
+            return;
+        }
+        const uint16_t offset = y * bytesWidth + x / 8;
+        const uint8_t mask = 0x80 >> (x & 7);
+        setBit(low[offset], mask, level & 0x01);
+        setBit(high[offset], mask, level & 0x02);
+    }
+
+    uint8_t getPixel(uint16_t x, uint16_t y) const
+    {
+        if (x >= width || y >= height)
+        {
+            return 0;
+        }
+        const uint16_t offset = y * bytesWidth + x / 8;
+        const uint8_t mask = 0x80 >> (x & 7);
+        return ((high[offset] & mask) ? 0x02 : 0) | ((low[offset] & mask) ? 0x01 : 0);
+    }
+
+    void fill(uint8_t level)
+    {
+        low.fill(level & 0x01 ? 0xff : 0x00);
+        high.fill(level & 0x02 ? 0xff : 0x00);
+    }
+
+    // Converts a packed 2bpp image of the same size, returns false if the image is too small
+    bool loadPacked(embedded::ConstBytesView image)
+    {
+        constexpr uint16_t packedBytesWidth = (width + 3) / 4;
+        if (image.size() < packedBytesWidth * height)
+        {
+            return false;
+        }
+        for (uint16_t row = 0; row < height; ++row)
+        {
+            const uint16_t offset = row * bytesWidth;
+            splitGrayPlanes(image.begin() + row * packedBytesWidth, packedBytesWidth, &low[offset], &high[offset]);
+        }
+        return true;
+    }
+
+    embedded::ConstBytesView lowPlane() const { return { low.data(), planeSize }; }
+
+    embedded::ConstBytesView highPlane() const { return { high.data(), planeSize }; }
+
+    embedded::BytesView lowPlane() { return { low.data(), planeSize }; }
+
+    embedded::BytesView highPlane() { return { high.data(), planeSize }; }
+
+private:
+    static void setBit(uint8_t &byte, uint8_t mask, bool set)
+    {
+        byte = set ? byte | mask : byte & ~mask;
+    }
+
+    std::array<uint8_t, planeSize> low {};
+    std::array<uint8_t, planeSize> high {};
+};
+
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "graphics/BaseGeometry.h"
+#include "EpdCanvas.h"
+#include "FrameDiff.h"
+#include "GrayPlaneConverter.h"
+#include "MemoryView.h"
+#include "PlanarGrayFrameBuffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace embedded
+{
+class EpdInterface;
+
+// Driver of the e-paper displays with SSD1677 family controllers.
+// The panel specifics are provided by PanelTraits:
+//     width, height - the panel geometry in pixels, the width should be a multiple of 8
+//     gateScanning, gateVoltage, sourceVoltage, booster, vcom, displayOption - the init sequence parameters
+//     dataEntryMode, borderWaveform, temperatureSensor, updateControl - the control registers values
+//     lutFullBW, lutPartBW, lutFull4Gray - the waveform tables
+//     partialRefreshMs, fullRefreshMs, grayRefreshMs - the longest expected waveform durations
+template<typename PanelTraits>
+class Ssd1677Display
+{
+public:
+    static constexpr int epdWidth = PanelTraits::width;
+    static constexpr int epdHeight = PanelTraits::height;
+    static_assert(epdWidth % 8 == 0, "The panel width should be a multiple of 8");
+    // the image and transfer sizes are 16-bit
+    static_assert(epdWidth * epdHeight / 4 <= UINT16_MAX, "The 4-gray frame size doesn't fit 16 bits");
+    static constexpr embedded::Rect<uint16_t> fullScreenRect =
+            { { 0, 0 }
+              , { epdWidth, epdHeight } };
+
+    using GrayFrameBuffer = embedded::PlanarGrayFrameBuffer<epdWidth, epdHeight>;
+    // canvases in the layouts of the BW and packed 4-gray images accepted by displayFrame and displayWindow
+    using BWCanvas = embedded::EpdCanvas<1, epdWidth, epdHeight>;
+    using GrayCanvas = embedded::EpdCanvas<2, epdWidth, epdHeight>;
+
+    enum class RefreshMode
+    {
+        FullBW, PartBW, Full4Gray
+    };
+
+    // 2 bits per pixel gray levels. The BW modes show the high bit only, both for fillWindow and for
+    // the planar frame buffer: Black and DarkGray are shown black, LightGray and White are shown white.
+    enum class Color : uint8_t
+    {
+        Black, DarkGray, LightGray, White
+    };
+
+    // Progress of the started refresh. The next command sent to the display waits until the refresh is done,
+    // the handle allows to do something else meanwhile.
+    // The completion is detected by polling the busy pin, or by signalBusyReleased() called from the handler
+    // of the busy pin falling edge interrupt if the application sets one up.
+    class [[nodiscard]] RefreshHandle
+    {
+    public:
+        using Callback = void (*)(void *context);
+
+        // The default handle is the completed one, it's returned if nothing was started
+        RefreshHandle() = default;
+
+        bool isDone();
+        void wait();
+        // The callback is called once, from isDone() or wait() which detects the completion
+        void setCallback(Callback callback, void *context = nullptr);
+        void signalBusyReleased() { busyReleased = true; }
+
+        // False for the default handle, i.e. if the call didn't start the refresh
+        bool isStarted() const { return hal != nullptr; }
+
+        // The tick by which the refresh is expected to be completed
+        uint32_t deadline() const { return deadlineTicks; }
+        bool isOverdue() const;
+
+    private:
+        friend class Ssd1677Display;
+
+        RefreshHandle(const embedded::EpdInterface &hal, uint32_t deadlineTicks)
+                : hal(&hal)
+                  , deadlineTicks(deadlineTicks)
+                  , done(false) {}
+
+        const embedded::EpdInterface *hal = nullptr;
+        uint32_t deadlineTicks = 0;
+        Callback callback = nullptr;
+        void *callbackContext = nullptr;
+        volatile bool busyReleased = false;
+        bool done = true;
+    };
+
+    // Clockwise rotation of a landscape image onto the portrait panel
+    enum class Rotation
+    {
+        Rotate90, Rotate270
+    };
+
+    explicit Ssd1677Display(embedded::EpdInterface &hal)
+            : hal(hal) {}
+
+    int init() const;
+    void wakeUp() const;
+    void sleep() const;
+    void reset() const;
+    RefreshHandle clear(RefreshMode mode) const;
+    RefreshHandle displayFrame(embedded::ConstBytesView image, RefreshMode mode = RefreshMode::FullBW) const;
+    RefreshHandle displayWindow(embedded::ConstBytesView image,
+                       embedded::Rect<uint16_t> rect,
+                       RefreshMode mode = RefreshMode::PartBW) const;
+    // Uploads the BW frame rectangles and starts one refresh for all of them, the Full4Gray mode isn't supported
+    RefreshHandle displayWindows(embedded::ConstBytesView image,
+                                 const embedded::Rect<uint16_t> *rects,
+                                 uint8_t rectsCount,
+                                 RefreshMode mode = RefreshMode::PartBW) const;
+    // Uploads only the parts of the BW frame changed since the last frame passed through the diff, in the BW modes
+    template<uint8_t maxRects>
+    RefreshHandle displayChanges(embedded::ConstBytesView image,
+                                 embedded::FrameDiff<epdWidth, epdHeight, maxRects> &diff,
+                                 RefreshMode mode = RefreshMode::PartBW) const
+    {
+        // the diff remembers the frame, so it shouldn't see the frames which can't be shown
+        if (mode == RefreshMode::Full4Gray)
+        {
+            return {};
+        }
+        const auto rectsCount = diff.update(image);
+        if (rectsCount == 0)
+        {
+            return {};
+        }
+        auto handle = displayWindows(image, diff.begin(), rectsCount, mode);
+        if (!handle.isStarted())
+        {
+            diff.invalidate();
+        }
+        return handle;
+    }
+    // The planar frame buffer is uploaded without conversion, the rectangle is extended to the byte boundaries.
+    // In the BW modes only the high plane is uploaded.
+    RefreshHandle displayFrame(const GrayFrameBuffer &frame, RefreshMode mode = RefreshMode::Full4Gray) const;
+    RefreshHandle displayWindow(const GrayFrameBuffer &frame,
+                       embedded::Rect<uint16_t> rect,
+                       RefreshMode mode = RefreshMode::Full4Gray) const;
+    // 4-gray upload of a packed 2bpp frame through EpdAsyncPipeline:
+    // the next rows are converted while the previous ones are being sent.
+    // The refresh isn't started if a transfer fails.
+    template<typename Pipeline>
+    RefreshHandle displayFrame(embedded::ConstBytesView image, Pipeline &pipeline) const;
+    // Uploads a landscape epdHeight x epdWidth image in the BW or packed 2bpp layout rotated to the panel orientation.
+    // The image is transposed by 8x8 pixel blocks while being sent, no rotated copy is made.
+    RefreshHandle displayRotatedFrame(embedded::ConstBytesView image,
+                                      Rotation rotation,
+                                      RefreshMode mode = RefreshMode::FullBW) const;
+    // Renders the rectangle by strips of stripRows rows without a frame buffer.
+    // The renderer is called as render(embedded::BytesView strip, embedded::Rect<uint16_t> stripRect) and should fill
+    // the strip rows in the BW layout or, in the Full4Gray mode, in the packed 2bpp one.
+    // In the Full4Gray mode the RAM planes are uploaded one after another, so every strip is rendered twice.
+    // The rectangle is extended to the byte boundaries and clipped to the screen.
+    template<uint16_t stripRows = 8, typename Renderer>
+    RefreshHandle displayStrips(embedded::Rect<uint16_t> rect, Renderer render, RefreshMode mode = RefreshMode::PartBW) const;
+    // Fills the rectangle with a solid color, the rectangle is extended to the byte boundaries and clipped to the screen
+    RefreshHandle fillWindow(embedded::Rect<uint16_t> rect, Color color, RefreshMode mode = RefreshMode::PartBW) const;
+    void waitUntilIdle() const;
+
+private:
+    void loadLut(RefreshMode mode) const;
+    void sendCommand(uint8_t command) const;
+    void sendCommand(uint8_t command, uint8_t arg) const
+    {
+        sendCommand(command);
+        sendData(arg);
+    }
+
+    void sendCommand(uint8_t command, embedded::ConstBytesView data) const
+    {
+        sendCommand(command);
+        sendData(data);
+    }
+
+    void sendData(unsigned char data) const;
+    void sendData(embedded::ConstBytesView data) const;
+    void sendStartPoint(embedded::Point<uint16_t> point) const;
+    void sendAxisLimits(embedded::Rect<uint16_t> rect) const;
+    void prepareToSendScreenData(embedded::Rect<uint16_t> rectToBeSent) const;
+    // The rectangle upload methods clip it to the screen and return false if the image doesn't cover it
+    bool sendRectDataBW(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const;
+    bool sendPlaneRect(uint8_t command, embedded::ConstBytesView plane, embedded::Rect<uint16_t> rect) const;
+    bool sendRectData4Gray(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const;
+    bool send4GrayOnePlane(const embedded::ConstBytesView &image, embedded::Rect<uint16_t> rect, bool first) const;
+    void sendRotatedPlane(embedded::ConstBytesView image, Rotation rotation, bool gray, bool first) const;
+    void fillRamPlane(uint8_t command, const embedded::Rect<uint16_t> &rect, bool white) const;
+    void autoWriteRamPlane(uint8_t command, bool white) const;
+    RefreshHandle startRefresh(RefreshMode mode) const;
+    static constexpr uint32_t refreshDuration(RefreshMode mode)
+    {
+        switch (mode)
+        {
+            case RefreshMode::PartBW:
+                return PanelTraits::partialRefreshMs;
+            case RefreshMode::FullBW:
+                return PanelTraits::fullRefreshMs;
+            case RefreshMode::Full4Gray:
+                return PanelTraits::grayRefreshMs;
+        }
+        return PanelTraits::grayRefreshMs;
+    }
+    void sendUpdateControl(uint8_t value) const;
+    void waitForRefresh() const;
+    void invalidateControllerState() const;
+    static embedded::Rect<uint16_t> alignWindow(embedded::Rect<uint16_t> rect, uint16_t align);
+    static embedded::Rect<uint16_t> clipWindow(embedded::Rect<uint16_t> rect);
+    static bool coversWindow(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect, uint8_t bitsPerPixel);
+
+    // The last values sent to the controller, the commands repeating them are skipped.
+    // It's dropped on the reset and the cursor is dropped after any RAM write which moves it.
+    struct ControllerState
+    {
+        std::optional<RefreshMode> lut;
+        std::optional<std::array<uint16_t, 4>> window;
+        std::optional<std::array<uint16_t, 2>> cursor;
+        std::optional<uint8_t> updateControl;
+        // a refresh was started and the busy pin wasn't checked after that
+        bool refreshing = false;
+    };
+
+    embedded::EpdInterface &hal;
+    mutable ControllerState controllerState;
+};
+
+template<typename PanelTraits>
+template<uint16_t stripRows, typename Renderer>
+typename Ssd1677Display<PanelTraits>::RefreshHandle
+Ssd1677Display<PanelTraits>::displayStrips(embedded::Rect<uint16_t> rect, Renderer render, RefreshMode mode) const
+{
+    static_assert(stripRows > 0, "The strip can't be empty");
+    // the strip buffers keep the screen wide rows
+    rect = clipWindow(alignWindow(rect, 8));
+    if (rect.size.width == 0 || rect.size.height == 0)
+    {
+        return {};
+    }
+    const bool gray = mode == RefreshMode::Full4Gray;
+    const uint16_t planeRowBytes = rect.size.width / 8;
+    const uint16_t renderRowBytes = gray ? planeRowBytes * 2 : planeRowBytes;
+    uint8_t renderBuffer[stripRows * epdWidth / 4];
+    uint8_t planeBuffer[stripRows * epdWidth / 8];
+
+    for (const bool first: { true, false })
+    {
+        if (!first && !gray)
+        {
+            break;
+        }
+        prepareToSendScreenData(rect);
+        sendCommand(first ? 0x24 : 0x26);
+        for (uint16_t row = 0; row < rect.size.height; row += stripRows)
+        {
+            const uint16_t rows = std::min<uint16_t>(stripRows, rect.size.height - row);
+            render(embedded::BytesView { renderBuffer, uint16_t(rows * renderRowBytes) },
+                   embedded::Rect<uint16_t> { { rect.topLeft.x, uint16_t(rect.topLeft.y + row) },
+                                              { rect.size.width, rows } });
+            if (!gray)
+            {
+                sendData({ renderBuffer, uint16_t(rows * planeRowBytes) });
+                continue;
+            }
+            for (uint16_t stripRow = 0; stripRow < rows; ++stripRow)
+            {
+                extractGrayPlane(renderBuffer + stripRow * renderRowBytes, renderRowBytes,
+                                 planeBuffer + stripRow * planeRowBytes, first);
+            }
+            sendData({ planeBuffer, uint16_t(rows * planeRowBytes) });
+        }
+    }
+
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+template<typename Pipeline>
+typename Ssd1677Display<PanelTraits>::RefreshHandle
+Ssd1677Display<PanelTraits>::displayFrame(embedded::ConstBytesView image, Pipeline &pipeline) const
+{
+    constexpr uint16_t packedRowBytes = epdWidth / 4;
+    constexpr uint16_t planeRowBytes = epdWidth / 8;
+    static_assert(Pipeline::stripBufferSize >= planeRowBytes, "The pipeline buffer can't keep a row");
+    if (image.size() < packedRowBytes * epdHeight)
+    {
+        return {};
+    }
+
+    // the pipeline commands don't go through sendCommand()
+    waitForRefresh();
+    for (const bool first: { true, false })
+    {
+        prepareToSendScreenData(fullScreenRect);
+        pipeline.queueCommand(first ? 0x24 : 0x26);
+        controllerState.cursor.reset();
+        auto source = image.begin();
+        for (uint16_t row = 0; row < epdHeight;)
+        {
+            auto buffer = pipeline.acquireBuffer();
+            uint16_t size = 0;
+            for (; row < epdHeight && size + planeRowBytes <= buffer.size(); ++row, source += packedRowBytes)
+            {
+                size += extractGrayPlane(source, packedRowBytes, buffer.begin() + size, first);
+            }
+            pipeline.queueData(size);
+        }
+        // the window of the next plane is set by the blocking transfers
+        if (!pipeline.flush())
+        {
+            return {};
+        }
+    }
+
+    return startRefresh(RefreshMode::Full4Gray);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,624 @@
+#pragma once
+
+#include "Ssd1677Display.h"
+#include "EpdInterface.h"
+#include "GrayPlaneConverter.h"
+
+#include <algorithm>
+
+namespace embedded
+{
+
+namespace detail
+{
+
+// Transposes 8x8 bits block, the first row is in the high byte and the first column is in the high bits
+inline uint64_t transpose8x8(uint64_t block)
+{
+    uint64_t t = (block ^ (block >> 7)) & 0x00AA00AA00AA00AAull;
+    block ^= t ^ (t << 7);
+    t = (block ^ (block >> 14)) & 0x0000CCCC0000CCCCull;
+    block ^= t ^ (t << 14);
+    t = (block ^ (block >> 28)) & 0x00000000F0F0F0F0ull;
+    block ^= t ^ (t << 28);
+    return block;
+}
+
+// auto write RAM parameter: the fill value is in the bit 7, the step height and width are the whole RAM
+inline constexpr uint8_t autoWriteWhite = 0xF7;
+inline constexpr uint8_t autoWriteBlack = 0x77;
+
+}
+
+template<typename PanelTraits>
+int Ssd1677Display<PanelTraits>::init() const
+{
+    reset();
+    sendCommand(0x12);
+    embedded::delay(10);
+
+    autoWriteRamPlane(0x46, true);
+    autoWriteRamPlane(0x47, true);
+
+    // setting gate number, the last gate line index and the scanning order
+    constexpr uint16_t lastGate = epdHeight - 1;
+    constexpr uint8_t gateSettings[] { uint8_t(lastGate & 0xFF), uint8_t(lastGate >> 8), PanelTraits::gateScanning };
+    sendCommand(0x01);
+    sendData(gateSettings);
+
+    sendCommand(0x03, PanelTraits::gateVoltage);
+
+    // set source voltage
+    sendCommand(0x04);
+    sendData(PanelTraits::sourceVoltage);
+
+    // set data entry sequence
+    sendCommand(0x11, PanelTraits::dataEntryMode);
+
+    // set border
+    sendCommand(0x3C, PanelTraits::borderWaveform);
+
+    // set booster strength
+    sendCommand(0x0C);
+    sendData(PanelTraits::booster);
+
+    // set internal sensor on
+    sendCommand(0x18, PanelTraits::temperatureSensor);
+
+    // set vcom value
+    sendCommand(0x2C, PanelTraits::vcom);
+
+    // set display option, these setting turn on previous function
+    sendCommand(0x37);
+    sendData(PanelTraits::displayOption);
+
+    sendAxisLimits({ {   0       , 0 }
+                     , { epdWidth, epdHeight } });
+
+    // Display Update Control 2
+    sendUpdateControl(PanelTraits::updateControl);
+    return 0;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendCommand(uint8_t command) const
+{
+    switch (command)
+    {
+        case 0x24:
+        case 0x26:
+        case 0x46:
+        case 0x47:
+            // RAM writes move the address counter
+            controllerState.cursor.reset();
+            break;
+        default:
+            break;
+    }
+    waitForRefresh();
+    hal.setDcPin(false);
+    hal.spiTransfer(command);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendData(unsigned char data) const
+{
+    hal.setDcPin(true);
+    hal.spiTransfer(data);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::waitUntilIdle() const
+{
+    if (hal.getBusyState())
+    {
+        while (hal.getBusyState())
+        {
+            embedded::delay(1);
+        }
+    }
+}
+
+// The controller ignores commands during the refresh
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::waitForRefresh() const
+{
+    if (controllerState.refreshing)
+    {
+        controllerState.refreshing = false;
+        waitUntilIdle();
+    }
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::reset() const
+{
+    invalidateControllerState();
+    hal.resetEpd();
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::displayFrame(embedded::ConstBytesView image, RefreshMode mode) const
+{
+    const uint16_t counter = epdWidth * epdHeight / (mode != RefreshMode::Full4Gray ? 8 : 4);
+    if (image.size() < counter)
+    {
+        return {};
+    }
+
+    if (mode != RefreshMode::Full4Gray)
+    {
+        prepareToSendScreenData(fullScreenRect);
+        sendCommand(0x24);
+        sendData({ image.begin(), counter });
+    }
+    else if (!sendRectData4Gray(image, fullScreenRect))
+    {
+        return {};
+    }
+
+    return startRefresh(mode);
+}
+
+/******************************************************************************
+function :  Partial Display
+******************************************************************************/
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle
+Ssd1677Display<PanelTraits>::displayWindow(embedded::ConstBytesView image, embedded::Rect<uint16_t> rect, RefreshMode mode) const
+{
+    rect = alignWindow(rect, mode != RefreshMode::Full4Gray ? 8 : 4);
+
+    if (!sendRectDataBW(image, rect))
+    {
+        return {};
+    }
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle
+Ssd1677Display<PanelTraits>::displayRotatedFrame(embedded::ConstBytesView image, Rotation rotation, RefreshMode mode) const
+{
+    const bool gray = mode == RefreshMode::Full4Gray;
+    if (image.size() < epdWidth * epdHeight / (gray ? 4 : 8))
+    {
+        return {};
+    }
+    sendRotatedPlane(image, rotation, gray, true);
+    if (gray)
+    {
+        sendRotatedPlane(image, rotation, gray, false);
+    }
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendRotatedPlane(embedded::ConstBytesView image, Rotation rotation, bool gray, bool first) const
+{
+    // the source is epdHeight pixels wide and epdWidth pixels high
+    constexpr uint16_t sourceBytesWidth = epdHeight / 8;
+    constexpr uint16_t targetBytesWidth = epdWidth / 8;
+    const uint16_t sourceRowBytes = gray ? sourceBytesWidth * 2 : sourceBytesWidth;
+    // a byte of the 1bpp plane, the 2bpp source bytes are split on the fly
+    const auto sourceByte = [&](uint16_t row, uint16_t column)
+    {
+        const auto rowPtr = image.begin() + row * sourceRowBytes;
+        if (!gray)
+        {
+            return rowPtr[column];
+        }
+        uint8_t planeByte;
+        extractGrayPlane(rowPtr + column * 2, 2, &planeByte, first);
+        return planeByte;
+    };
+
+    prepareToSendScreenData(fullScreenRect);
+    sendCommand(first ? 0x24 : 0x26);
+    uint8_t strip[8][targetBytesWidth];
+    const auto transfer = hal.startDataTransfer();
+    // every 8 target rows are made of one byte column of the source
+    for (uint16_t targetRow = 0; targetRow < epdHeight; targetRow += 8)
+    {
+        const uint16_t sourceColumn = rotation == Rotation::Rotate90
+                                      ? targetRow / 8
+                                      : sourceBytesWidth - 1 - targetRow / 8;
+        for (uint16_t targetColumn = 0; targetColumn < targetBytesWidth; ++targetColumn)
+        {
+            uint64_t block = 0;
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                const uint16_t x = targetColumn * 8 + i;
+                const uint16_t sourceRow = rotation == Rotation::Rotate90 ? epdWidth - 1 - x : x;
+                block = block << 8 | sourceByte(sourceRow, sourceColumn);
+            }
+            block = detail::transpose8x8(block);
+            for (uint8_t i = 0; i < 8; ++i)
+            {
+                // the source columns go in the reverse order after the rotation by 270 degrees
+                const uint8_t row = rotation == Rotation::Rotate90 ? i : 7 - i;
+                strip[row][targetColumn] = uint8_t(block >> (56 - i * 8));
+            }
+        }
+        transfer.send({ &strip[0][0], sizeof(strip) });
+    }
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::displayWindows(embedded::ConstBytesView image,
+                                                             const embedded::Rect<uint16_t> *rects,
+                                                             uint8_t rectsCount,
+                                                             RefreshMode mode) const
+{
+    // the BW image has no second plane for the 4-gray waveform
+    if (mode == RefreshMode::Full4Gray || image.size() < epdWidth * epdHeight / 8)
+    {
+        return {};
+    }
+    bool sent = false;
+    for (uint8_t i = 0; i < rectsCount; ++i)
+    {
+        sent |= sendRectDataBW(image, alignWindow(rects[i], 8));
+    }
+    return sent ? startRefresh(mode) : RefreshHandle {};
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::displayFrame(const GrayFrameBuffer &frame, RefreshMode mode) const
+{
+    return displayWindow(frame, fullScreenRect, mode);
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::displayWindow(const GrayFrameBuffer &frame, embedded::Rect<uint16_t> rect, RefreshMode mode) const
+{
+    rect = alignWindow(rect, 8);
+    if (mode != RefreshMode::Full4Gray)
+    {
+        // the high bit tells the light levels from the dark ones
+        if (!sendPlaneRect(0x24, frame.highPlane(), rect))
+        {
+            return {};
+        }
+    }
+    else if (!sendPlaneRect(0x24, frame.lowPlane(), rect) || !sendPlaneRect(0x26, frame.highPlane(), rect))
+    {
+        return {};
+    }
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::fillWindow(embedded::Rect<uint16_t> rect, Color color, RefreshMode mode) const
+{
+    // both RAM planes are 1 bit per pixel whatever the mode is
+    rect = clipWindow(alignWindow(rect, 8));
+    if (rect.size.width == 0 || rect.size.height == 0)
+    {
+        return {};
+    }
+    const auto level = static_cast<uint8_t>(color);
+    if (mode != RefreshMode::Full4Gray)
+    {
+        fillRamPlane(0x24, rect, level & 0x02);
+    }
+    else
+    {
+        fillRamPlane(0x24, rect, level & 0x01);
+        fillRamPlane(0x26, rect, level & 0x02);
+    }
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+embedded::Rect<uint16_t> Ssd1677Display<PanelTraits>::alignWindow(embedded::Rect<uint16_t> rect, uint16_t align)
+{
+    if (auto restX = rect.topLeft.x % align; restX)
+    {
+        rect.topLeft.x -= restX;
+        rect.size.width += restX;
+    }
+    if (auto restWidth = rect.size.width % align; restWidth)
+    {
+        rect.size.width += align - restWidth;
+    }
+    return rect;
+}
+
+// The aligned rectangle stays aligned since the width is a multiple of 8
+template<typename PanelTraits>
+embedded::Rect<uint16_t> Ssd1677Display<PanelTraits>::clipWindow(embedded::Rect<uint16_t> rect)
+{
+    rect.topLeft.x = std::min<uint16_t>(rect.topLeft.x, epdWidth);
+    rect.topLeft.y = std::min<uint16_t>(rect.topLeft.y, epdHeight);
+    rect.size.width = std::min<uint16_t>(rect.size.width, epdWidth - rect.topLeft.x);
+    rect.size.height = std::min<uint16_t>(rect.size.height, epdHeight - rect.topLeft.y);
+    return rect;
+}
+
+// The rectangle should be clipped to the screen
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::coversWindow(embedded::ConstBytesView image,
+                                               const embedded::Rect<uint16_t> &rect,
+                                               uint8_t bitsPerPixel)
+{
+    if (rect.size.width == 0 || rect.size.height == 0)
+    {
+        return false;
+    }
+    const uint32_t rowBytes = epdWidth * bitsPerPixel / 8;
+    const uint32_t endByte = uint32_t(rect.topLeft.y + rect.size.height - 1) * rowBytes
+                             + uint32_t(rect.topLeft.x + rect.size.width) * bitsPerPixel / 8;
+    return image.size() >= endByte;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::fillRamPlane(uint8_t command, const embedded::Rect<uint16_t> &rect, bool white) const
+{
+    prepareToSendScreenData(rect);
+    sendCommand(command);
+    uint8_t rowData[epdWidth / 8];
+    const uint16_t bytesWidth = rect.size.width / 8;
+    std::fill_n(rowData, bytesWidth, white ? 0xff : 0x00);
+    const auto transfer = hal.startDataTransfer();
+    for (auto rowIdx = 0; rowIdx < rect.size.height; ++rowIdx)
+    {
+        transfer.send({ rowData, bytesWidth });
+    }
+}
+
+// The controller fills the whole RAM plane by itself, it takes a few milliseconds instead of the SPI transfer
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::autoWriteRamPlane(uint8_t command, bool white) const
+{
+    sendCommand(command, white ? detail::autoWriteWhite : detail::autoWriteBlack);
+    waitUntilIdle();
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::sendRectDataBW(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const
+{
+    return sendPlaneRect(0x24, image, rect);
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::sendPlaneRect(uint8_t command,
+                                   embedded::ConstBytesView plane,
+                                   embedded::Rect<uint16_t> rect) const
+{
+    rect = clipWindow(rect);
+    if (!coversWindow(plane, rect, 1))
+    {
+        return false;
+    }
+    prepareToSendScreenData(rect);
+    sendCommand(command);
+    const uint16_t bytesWidth = rect.size.width / 8;
+    constexpr uint16_t fullBytesWidth = epdWidth / 8;
+    auto startBytePtr = plane.begin() + rect.topLeft.x / 8 + rect.topLeft.y * fullBytesWidth;
+    if (bytesWidth == fullBytesWidth)
+    {
+        // full width rows are contiguous in the image
+        sendData({ startBytePtr, uint16_t(fullBytesWidth * rect.size.height) });
+        return true;
+    }
+    const auto transfer = hal.startDataTransfer();
+    for (auto colIdx = 0; colIdx < rect.size.height; ++colIdx, startBytePtr += fullBytesWidth)
+    {
+        transfer.send({ startBytePtr, bytesWidth });
+    }
+    return true;
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::sendRectData4Gray(embedded::ConstBytesView image, const embedded::Rect<uint16_t> &rect) const
+{
+    return send4GrayOnePlane(image, rect, true) && send4GrayOnePlane(image, rect, false);
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::send4GrayOnePlane(const embedded::ConstBytesView &image,
+                                       embedded::Rect<uint16_t> rect,
+                                       bool first) const
+{
+    // the row buffer keeps one screen wide row
+    rect = clipWindow(rect);
+    if (!coversWindow(image, rect, 2))
+    {
+        return false;
+    }
+    prepareToSendScreenData(rect);
+    sendCommand(first ? 0x24 : 0x26);
+    constexpr uint16_t fullBytesWidth = epdWidth / 4;
+    const uint16_t bytesWidth = rect.size.width / 4;
+    uint8_t rowData[epdWidth / 8];
+    auto startBytePtr = image.begin() + rect.topLeft.x / 4 + rect.topLeft.y * fullBytesWidth;
+    const auto transfer = hal.startDataTransfer();
+    for (auto colIdx = 0; colIdx < rect.size.height; ++colIdx, startBytePtr += fullBytesWidth)
+    {
+        const auto rowBytes = extractGrayPlane(startBytePtr, bytesWidth, rowData, first);
+        transfer.send({ rowData, rowBytes });
+    }
+    return true;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::prepareToSendScreenData(embedded::Rect<uint16_t> rectToBeSent) const
+{
+    sendAxisLimits(rectToBeSent);
+    sendStartPoint(rectToBeSent.topLeft);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendAxisLimits(embedded::Rect<uint16_t> rect) const
+{
+#pragma pack(push, 2)
+    union LimitsData
+    {
+        struct
+        {
+            uint16_t start;
+            uint16_t end;
+        } coords;
+        uint8_t data[4];
+    };
+#pragma pack(pop)
+    const auto &bottomRight = rect.bottomRight();
+    const std::array<uint16_t, 4> window { rect.topLeft.x, bottomRight.x, rect.topLeft.y, bottomRight.y };
+    if (controllerState.window == window)
+    {
+        return;
+    }
+    controllerState.window = window;
+    LimitsData limitsData { .coords = { rect.topLeft.x, bottomRight.x } };
+    sendCommand(0x44, limitsData.data);
+    limitsData.coords = { rect.topLeft.y, bottomRight.y };
+    sendCommand(0x45, limitsData.data);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::loadLut(RefreshMode mode) const
+{
+    if (controllerState.lut == mode)
+    {
+        return;
+    }
+    controllerState.lut = mode;
+    sendCommand(0x32);
+    switch (mode)
+    {
+        case RefreshMode::PartBW:
+            sendData(PanelTraits::lutPartBW);
+            break;
+        case RefreshMode::FullBW:
+            sendData(PanelTraits::lutFullBW);
+            break;
+        case RefreshMode::Full4Gray:
+            sendData(PanelTraits::lutFull4Gray);
+            break;
+    }
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::clear(RefreshMode mode) const
+{
+    prepareToSendScreenData(fullScreenRect);
+
+    autoWriteRamPlane(0x46, true);
+    if (mode == RefreshMode::Full4Gray)
+    {
+        autoWriteRamPlane(0x47, true);
+    }
+    return startRefresh(mode);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendStartPoint(embedded::Point<uint16_t> point) const
+{
+    union CoordData
+    {
+        struct
+        {
+            uint16_t coord;
+        };
+        uint8_t data[2];
+    };
+    const std::array<uint16_t, 2> cursor { point.x, point.y };
+    if (controllerState.cursor == cursor)
+    {
+        return;
+    }
+    CoordData coordData { .coord = point.x };
+    sendCommand(0x4E, coordData.data);
+    coordData.coord = point.y;
+    sendCommand(0x4F, coordData.data);
+    controllerState.cursor = cursor;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendUpdateControl(uint8_t value) const
+{
+    if (controllerState.updateControl == value)
+    {
+        return;
+    }
+    controllerState.updateControl = value;
+    sendCommand(0x22, value);
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::invalidateControllerState() const
+{
+    controllerState = {};
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sleep() const
+{
+    sendCommand(0X10, 0x03);   //deep sleep
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::sendData(embedded::ConstBytesView data) const
+{
+    hal.setDcPin(true);
+    hal.spiTransfer(data);
+}
+
+template<typename PanelTraits>
+typename Ssd1677Display<PanelTraits>::RefreshHandle Ssd1677Display<PanelTraits>::startRefresh(RefreshMode mode) const
+{
+    loadLut(mode);
+    sendCommand(0x20);
+    controllerState.refreshing = true;
+    return RefreshHandle { hal, embedded::getMillisecondTicks() + refreshDuration(mode) };
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::RefreshHandle::isDone()
+{
+    if (done)
+    {
+        return true;
+    }
+    if (!busyReleased && hal->getBusyState())
+    {
+        return false;
+    }
+    done = true;
+    if (callback)
+    {
+        callback(callbackContext);
+    }
+    return true;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::RefreshHandle::wait()
+{
+    while (!isDone())
+    {
+        embedded::delay(1);
+    }
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::RefreshHandle::setCallback(Callback callback, void *context)
+{
+    this->callback = callback;
+    callbackContext = context;
+}
+
+template<typename PanelTraits>
+bool Ssd1677Display<PanelTraits>::RefreshHandle::isOverdue() const
+{
+    return !done && int32_t(embedded::getMillisecondTicks() - deadlineTicks) > 0;
+}
+
+template<typename PanelTraits>
+void Ssd1677Display<PanelTraits>::wakeUp() const
+{
+    reset();
+}
+
+} // namespace embedded